@@ -0,0 +1,69 @@
+// Miner tx sized messages with an extra nonce near the end: keccak1600 of the whole message
+// against resuming a keccak_ctx absorbed up to the nonce, built and run by run.sh:
+// gcc -std=gnu11 -O2 -I../src -I../src/contrib/epee/include -c ../src/crypto/keccak.c ../src/crypto/keccak-lanes.c
+// g++ -std=c++17 -O2 -I../src keccak_midstate.cpp keccak.o keccak-lanes.o
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+extern "C" {
+#include "crypto/keccak.h"
+}
+
+template <class F>
+static double ns_per_hash(int rounds, F&& f)
+{
+  double best = 1e30;
+  for (int run = 0; run < 5; ++run)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+      f(i);
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / rounds;
+    if (ns < best)
+      best = ns;
+  }
+  return best;
+}
+
+int main()
+{
+  const int rounds = 100000;
+  std::mt19937 random(1);
+
+  std::printf("bytes  nonce at  full keccak  resumed midstate  (ns/hash, best of 5)\n");
+  for (size_t size : { 120, 500, 2000 })
+  {
+    std::vector<uint8_t> message(size);
+    for (uint8_t& byte : message)
+      byte = random();
+    const size_t nonce_offset = size - 40;
+
+    keccak_ctx midstate;
+    keccak_init(&midstate);
+    keccak_absorb(&midstate, message.data(), nonce_offset);
+
+    uint8_t full[200], resumed[200];
+    const double with_full = ns_per_hash(rounds, [&](int i) {
+      memcpy(&message[nonce_offset], &i, sizeof(i));
+      keccak1600(message.data(), static_cast<int>(size), full);
+    });
+    const double with_midstate = ns_per_hash(rounds, [&](int i) {
+      memcpy(&message[nonce_offset], &i, sizeof(i));
+      keccak_ctx ctx = midstate;
+      keccak_absorb(&ctx, &message[nonce_offset], size - nonce_offset);
+      keccak_finalize(&ctx, resumed);
+    });
+    if (memcmp(full, resumed, 32))
+    {
+      std::printf("FAILED: midstate hash differs for %zu bytes\n", size);
+      return 1;
+    }
+    std::printf("%5zu  %8zu  %11.1f  %16.1f\n", size, nonce_offset, with_full, with_midstate);
+  }
+  return 0;
+}
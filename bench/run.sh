@@ -0,0 +1,13 @@
+#!/bin/bash -x
+
+DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+OUT="${TMPDIR:-/tmp}/cryptoforknote-bench"
+
+cd $DIR
+mkdir -p "$OUT"
+g++ -std=c++17 -O2 -I../src varint.cpp -o "$OUT/varint" && "$OUT/varint" || exit 1
+for c in tree-hash hash keccak keccak-lanes; do
+  gcc -std=gnu11 -O2 -I../src -I../src/contrib/epee/include -c ../src/crypto/$c.c -o "$OUT/$c.o" || exit 1
+done
+g++ -std=c++17 -O2 -I../src keccak_midstate.cpp "$OUT"/{keccak,keccak-lanes}.o -o "$OUT/keccak_midstate" && "$OUT/keccak_midstate" || exit 1
+g++ -std=c++17 -O2 -I../src -I../src/contrib/epee/include tree_hash.cpp "$OUT"/{tree-hash,hash,keccak,keccak-lanes}.o -o "$OUT/tree_hash" && "$OUT/tree_hash" || exit 1
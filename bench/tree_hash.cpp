@@ -0,0 +1,87 @@
+// tree_hash over 10, 1k and 100k leaves: the former alloca version, the C function with its
+// stack scratch and the thread_local scratch the crypto:: wrappers pass past it, built and run
+// by run.sh:
+// gcc -std=gnu11 -O2 -I../src -I../src/contrib/epee/include -c ../src/crypto/tree-hash.c ../src/crypto/hash.c ../src/crypto/keccak.c ../src/crypto/keccak-lanes.c
+// g++ -std=c++17 -O2 -I../src -I../src/contrib/epee/include tree_hash.cpp tree-hash.o hash.o keccak.o keccak-lanes.o
+
+#include <alloca.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "crypto/hash.h"
+
+using namespace crypto;
+
+// tree_hash as it was before the scratch API: the level below the root on the stack
+static void alloca_tree_hash(const char (*hashes)[HASH_SIZE], size_t count, char *root_hash)
+{
+  if (count == 1)
+  {
+    memcpy(root_hash, hashes, HASH_SIZE);
+    return;
+  }
+  if (count == 2)
+  {
+    cn_fast_hash_64(hashes, root_hash);
+    return;
+  }
+  size_t cnt = count - 1;
+  for (size_t i = 1; i < sizeof(size_t) << 3; i <<= 1)
+    cnt |= cnt >> i;
+  cnt &= ~(cnt >> 1);
+  char (*ints)[HASH_SIZE] = reinterpret_cast<char (*)[HASH_SIZE]>(alloca(cnt * HASH_SIZE));
+  memcpy(ints, hashes, (2 * cnt - count) * HASH_SIZE);
+  cn_fast_hash_batch(hashes[2 * cnt - count], 2 * HASH_SIZE, count - cnt, ints + 2 * cnt - count);
+  while (cnt > 2)
+  {
+    cnt >>= 1;
+    cn_fast_hash_batch(ints, 2 * HASH_SIZE, cnt, ints);
+  }
+  cn_fast_hash_64(ints[0], root_hash);
+}
+
+template <class F>
+static double us_per_tree(int rounds, F&& f)
+{
+  double best = 1e30;
+  for (int run = 0; run < 5; ++run)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i)
+      f();
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / rounds;
+    if (us < best)
+      best = us;
+  }
+  return best;
+}
+
+int main()
+{
+  std::mt19937 random(1);
+  std::vector<hash> leaves(100000);
+  for (hash& h : leaves)
+    for (size_t i = 0; i != HASH_SIZE; ++i)
+      reinterpret_cast<unsigned char*>(&h)[i] = random();
+  const char (*data)[HASH_SIZE] = reinterpret_cast<const char (*)[HASH_SIZE]>(leaves.data());
+
+  std::printf("leaves      alloca  C stack/heap  thread scratch  (us/tree, best of 5)\n");
+  for (size_t count : { 10, 1000, 100000 })
+  {
+    hash a, b, c;
+    const int rounds = count >= 100000 ? 5 : static_cast<int>(200000 / count);
+    const double with_alloca = us_per_tree(rounds, [&]() { alloca_tree_hash(data, count, reinterpret_cast<char*>(&a)); });
+    const double with_c = us_per_tree(rounds, [&]() { tree_hash(data, count, reinterpret_cast<char*>(&b)); });
+    const double with_scratch = us_per_tree(rounds, [&]() { tree_hash_scratch(data, count, reinterpret_cast<char*>(&c), tree_scratch(count)); });
+    if (a != b || a != c)
+    {
+      std::printf("FAILED: roots differ for %zu leaves\n", count);
+      return 1;
+    }
+    std::printf("%6zu  %10.1f  %12.1f  %14.1f\n", count, with_alloca, with_c, with_scratch);
+  }
+  return 0;
+}
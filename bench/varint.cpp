@@ -0,0 +1,95 @@
+// Varint decode and encode, the iterator functions against the pointer fast paths, built and run by run.sh:
+// g++ -std=c++17 -O2 -I../src varint.cpp
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "common/varint.h"
+
+// values of one encoded length, back to back, with slack at the end for the 64 bit loads
+static std::vector<uint8_t> encode_all(const std::vector<uint64_t>& values)
+{
+  std::vector<uint8_t> bytes;
+  for (uint64_t v : values)
+    tools::write_varint(std::back_inserter(bytes), v);
+  bytes.resize(bytes.size() + 16);
+  return bytes;
+}
+
+// not inlined, so each variant is compiled on its own rather than laid out inside main
+template <class F>
+__attribute__((noinline)) static double ns_per_value(size_t count, F&& f)
+{
+  double best = 1e30;
+  for (int run = 0; run < 5; ++run)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    f();
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+    if (ns < best)
+      best = ns;
+  }
+  return best;
+}
+
+int main()
+{
+  const size_t count = 1 << 20;
+  std::mt19937_64 random(1);
+  uint64_t checksum = 0;
+
+  std::printf("bytes  read iterator  read pointer  write iterator  write pointer  (ns/varint, best of 5)\n");
+  for (int length : { 1, 2, 3, 5, 9, 10 })
+  {
+    std::vector<uint64_t> values(count);
+    for (uint64_t& v : values)
+    {
+      const int bits = length == 10 ? 64 : 7 * length;
+      v = random() & (bits == 64 ? ~0ull : (1ull << bits) - 1);
+      v |= 1ull << (bits - 1); // top bit set so every value takes exactly length bytes
+    }
+    const std::vector<uint8_t> bytes = encode_all(values);
+    const uint8_t* begin = bytes.data();
+    const uint8_t* end = bytes.data() + bytes.size();
+
+    const double read_it = ns_per_value(count, [&]() {
+      const uint8_t* pos = begin;
+      for (size_t i = 0; i != count; ++i)
+      {
+        uint64_t v;
+        tools::read_varint<64>(pos, end, v);
+        checksum += v;
+      }
+    });
+    const double read_ptr = ns_per_value(count, [&]() {
+      const uint8_t* pos = begin;
+      for (size_t i = 0; i != count; ++i)
+      {
+        uint64_t v;
+        tools::read_varint_from(pos, end, v);
+        checksum += v;
+      }
+    });
+
+    std::vector<uint8_t> out(bytes.size());
+    const double write_it = ns_per_value(count, [&]() {
+      uint8_t* pos = out.data();
+      for (size_t i = 0; i != count; ++i)
+        tools::write_varint(pos, values[i]);
+      checksum += out[count / 2];
+    });
+    const double write_ptr = ns_per_value(count, [&]() {
+      uint8_t* pos = out.data();
+      for (size_t i = 0; i != count; ++i)
+        pos += tools::write_varint_to(pos, values[i]);
+      checksum += out[count / 2];
+    });
+
+    std::printf("%5d  %13.2f  %12.2f  %14.2f  %13.2f\n", length, read_it, read_ptr, write_it, write_ptr);
+  }
+  std::printf("checksum %llu\n", static_cast<unsigned long long>(checksum));
+  return 0;
+}
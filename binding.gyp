@@ -5,16 +5,20 @@
             "sources": [
                 "src/main.cc",
                 "src/cryptonote_basic/cryptonote_format_utils.cpp",
+                "src/cryptonote_basic/difficulty.cpp",
                 "src/offshore/pricing_record.cpp",
                 "src/zephyr_oracle/pricing_record.cpp",
                 "src/salvium_oracle/pricing_record.cpp",
                 "src/crypto/tree-hash.c",
+                "src/crypto/tree-hash-parallel.cpp",
                 "src/crypto/crypto.cpp",
                 "src/crypto/crypto-ops.c",
                 "src/crypto/crypto-ops-data.c",
                 "src/crypto/hash.c",
                 "src/crypto/keccak.c",
+                "src/crypto/keccak-lanes.c",
                 "src/common/base58.cpp",
+                "src/common/thread_pool.cpp",
             ],
             "include_dirs": [
                 "src",
@@ -29,10 +33,10 @@
                 ]
             },
             "cflags_c":  [
-                "-fno-exceptions -std=gnu11 -march=native -fPIC -DNDEBUG -Ofast -funroll-loops -fvariable-expansion-in-unroller -ftree-loop-if-convert-stores -fmerge-all-constants -fbranch-target-load-optimize2"
+                "-fno-exceptions -std=gnu11 -fPIC -DNDEBUG -Ofast -funroll-loops -fvariable-expansion-in-unroller -ftree-loop-if-convert-stores -fmerge-all-constants -fbranch-target-load-optimize2"
             ],
             "cflags_cc": [
-                "-fexceptions -frtti -std=c++17 -march=native -fPIC -DNDEBUG -Ofast -s -funroll-loops -fvariable-expansion-in-unroller -ftree-loop-if-convert-stores -fmerge-all-constants -fbranch-target-load-optimize2"
+                "-fexceptions -frtti -std=c++17 -fPIC -DNDEBUG -Ofast -s -funroll-loops -fvariable-expansion-in-unroller -ftree-loop-if-convert-stores -fmerge-all-constants -fbranch-target-load-optimize2"
             ],
             "xcode_settings": {
                 "OTHER_CFLAGS": [ "-fexceptions -frtti" ]
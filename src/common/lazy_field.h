@@ -0,0 +1,54 @@
+// Copyright (c) 2012-2013 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <memory>
+
+namespace tools
+{
+  // Member only some coins use. It takes one pointer until it is first written, so objects of
+  // other coins neither allocate nor zero it. Copies are deep, reads of an empty field see a
+  // default constructed T.
+  template <class T>
+  class lazy_field
+  {
+  public:
+    lazy_field() {}
+    lazy_field(const lazy_field& o) : m_value(o.m_value ? new T(*o.m_value) : nullptr) {}
+    lazy_field(lazy_field&& o) noexcept = default;
+
+    lazy_field& operator=(const lazy_field& o)
+    {
+      if (this != &o)
+        m_value.reset(o.m_value ? new T(*o.m_value) : nullptr);
+      return *this;
+    }
+    lazy_field& operator=(lazy_field&& o) noexcept = default;
+
+    bool empty() const { return !m_value; }
+    void reset() { m_value.reset(); }
+
+    T& get()
+    {
+      if (!m_value)
+        m_value.reset(new T());
+      return *m_value;
+    }
+
+    const T& get() const
+    {
+      static const T empty_value = T();
+      return m_value ? *m_value : empty_value;
+    }
+
+    T* operator->() { return &get(); }
+    const T* operator->() const { return &get(); }
+    T& operator*() { return get(); }
+    const T& operator*() const { return get(); }
+
+  private:
+    std::unique_ptr<T> m_value;
+  };
+}
@@ -0,0 +1,230 @@
+// Copyright (c) 2012-2013 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "thread_pool.h"
+
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace tools
+{
+  namespace
+  {
+    // queue owned by the current thread, outside threads share the last queue
+    thread_local size_t t_queue_index = SIZE_MAX;
+    // batches the current thread is inside of, as caller or by running one of their tasks.
+    // Only the outermost takes the config lock: a nested shared lock on a thread that already
+    // holds it is undefined and would queue behind a waiting set_threads forever.
+    thread_local unsigned t_batch_depth = 0;
+
+    struct batch_scope
+    {
+      batch_scope() { ++t_batch_depth; }
+      ~batch_scope() { --t_batch_depth; }
+    };
+
+    void pin_thread(std::thread& t, unsigned cpu)
+    {
+#ifdef __linux__
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      CPU_SET(cpu, &cpuset);
+      pthread_setaffinity_np(t.native_handle(), sizeof(cpuset), &cpuset);
+#else
+      (void)t;
+      (void)cpu;
+#endif
+    }
+  }
+  //---------------------------------------------------------------
+  threadpool& threadpool::instance()
+  {
+    static threadpool pool;
+    return pool;
+  }
+  //---------------------------------------------------------------
+  threadpool::threadpool() : m_threads(0), m_next_queue(0), m_queued(0), m_running(false)
+  {
+    start(std::max(std::thread::hardware_concurrency(), 1u), false);
+  }
+  //---------------------------------------------------------------
+  threadpool::~threadpool()
+  {
+    stop();
+  }
+  //---------------------------------------------------------------
+  void threadpool::set_threads(unsigned threads, bool pin_threads)
+  {
+    std::unique_lock<std::shared_timed_mutex> lock(m_config_mutex);
+    stop();
+    start(std::min(std::max(threads, 1u), max_threads()), pin_threads);
+  }
+  //---------------------------------------------------------------
+  void threadpool::start(unsigned threads, bool pin_threads)
+  {
+    m_threads = threads;
+    m_queues.clear();
+    for (unsigned i = 0; i < threads; ++i)
+      m_queues.emplace_back(new task_queue());
+
+    m_running = true;
+    const unsigned cpus = std::max(std::thread::hardware_concurrency(), 1u);
+    for (unsigned i = 0; i + 1 < threads; ++i)
+    {
+      m_workers.emplace_back(&threadpool::run, this, i);
+      if (pin_threads)
+        pin_thread(m_workers.back(), i % cpus);
+    }
+  }
+  //---------------------------------------------------------------
+  void threadpool::stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_sleep_mutex);
+      m_running = false;
+    }
+    m_sleep_cond.notify_all();
+    for (std::thread& t : m_workers)
+      t.join();
+    m_workers.clear();
+  }
+  //---------------------------------------------------------------
+  void threadpool::submit(waiter& w, job f)
+  {
+    size_t index = t_queue_index < m_queues.size() ? t_queue_index : m_next_queue++ % m_queues.size();
+    w.inc();
+    // counted before the task can be popped, so pop never takes m_queued below zero
+    {
+      std::lock_guard<std::mutex> lock(m_sleep_mutex);
+      ++m_queued;
+    }
+    {
+      task_queue& q = *m_queues[index];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      q.tasks.push_back(task{std::move(f), &w});
+    }
+    m_sleep_cond.notify_one();
+  }
+  //---------------------------------------------------------------
+  bool threadpool::pop(size_t index, task& t)
+  {
+    // own tasks newest first while they are still hot in cache
+    {
+      task_queue& q = *m_queues[index];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (!q.tasks.empty())
+      {
+        t = std::move(q.tasks.back());
+        q.tasks.pop_back();
+        --m_queued;
+        return true;
+      }
+    }
+    // steal the oldest task of another queue
+    for (size_t i = 1; i < m_queues.size(); ++i)
+    {
+      task_queue& q = *m_queues[(index + i) % m_queues.size()];
+      std::lock_guard<std::mutex> lock(q.mutex);
+      if (!q.tasks.empty())
+      {
+        t = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        --m_queued;
+        return true;
+      }
+    }
+    return false;
+  }
+  //---------------------------------------------------------------
+  bool threadpool::run_one(size_t index)
+  {
+    task t;
+    if (!pop(index, t))
+      return false;
+    {
+      // the batch of every queued task holds the config lock until the task is done
+      batch_scope scope;
+      t.f();
+    }
+    t.w->dec();
+    return true;
+  }
+  //---------------------------------------------------------------
+  void threadpool::run(size_t index)
+  {
+    t_queue_index = index;
+    while (true)
+    {
+      if (run_one(index))
+        continue;
+      std::unique_lock<std::mutex> lock(m_sleep_mutex);
+      if (!m_running)
+        break;
+      m_sleep_cond.wait(lock, [this]{ return m_queued > 0 || !m_running; });
+    }
+  }
+  //---------------------------------------------------------------
+  void threadpool::waiter::dec()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_pending == 0)
+      m_cond.notify_all();
+  }
+  //---------------------------------------------------------------
+  void threadpool::waiter::wait()
+  {
+    const size_t index = t_queue_index < m_pool.m_queues.size() ? t_queue_index : m_pool.m_queues.size() - 1;
+    while (m_pending > 0)
+    {
+      if (m_pool.run_one(index))
+        continue;
+      // every task of this waiter is taken, the remaining ones are running on workers
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cond.wait(lock, [this]{ return m_pending == 0; });
+    }
+    // the last dec may still hold m_mutex to notify, the waiter must outlive that
+    std::lock_guard<std::mutex> lock(m_mutex);
+  }
+  //---------------------------------------------------------------
+  void threadpool::parallel_for(size_t count, const std::function<void(size_t begin, size_t end)>& f)
+  {
+    std::shared_lock<std::shared_timed_mutex> lock(m_config_mutex, std::defer_lock);
+    if (t_batch_depth == 0)
+      lock.lock();
+    batch_scope scope;
+    const size_t chunks = m_threads > 1 ? std::min<size_t>(count, m_threads * 4) : 1;
+    if (chunks <= 1)
+    {
+      f(0, count);
+      return;
+    }
+
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    waiter w(*this);
+    for (size_t i = 0; i < chunks; ++i)
+    {
+      const size_t begin = count * i / chunks, end = count * (i + 1) / chunks;
+      submit(w, [&f, &error, &error_mutex, begin, end]() {
+        try
+        {
+          f(begin, end);
+        }
+        catch (...)
+        {
+          std::lock_guard<std::mutex> lock(error_mutex);
+          if (!error)
+            error = std::current_exception();
+        }
+      });
+    }
+    w.wait();
+    if (error)
+      std::rethrow_exception(error);
+  }
+}
@@ -0,0 +1,103 @@
+// Copyright (c) 2012-2013 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+namespace tools
+{
+  // Work stealing pool for bulk parse/hash jobs. Every worker owns a task deque: it takes its
+  // own tasks LIFO and steals FIFO from the other workers when it runs dry. Threads waiting
+  // on a waiter run queued tasks too, so a batch started from any thread uses that thread as
+  // well and nested batches can not deadlock.
+  class threadpool
+  {
+  public:
+    typedef std::function<void()> job;
+
+    static threadpool& instance();
+
+    // Total threads taking part in a batch: workers plus the thread that waits on it.
+    // Waits for running batches to finish before the workers are replaced. Clamped to
+    // [1, max_threads()].
+    void set_threads(unsigned threads, bool pin_threads = false);
+    unsigned get_threads() const { return m_threads; }
+    static unsigned max_threads() { return 4 * std::max(std::thread::hardware_concurrency(), 1u); }
+
+    // Calls f(begin, end) on [0, count) split into chunks across the pool and blocks until
+    // all chunks are done; rethrows the first exception thrown by a chunk. Calls from inside a
+    // chunk join the batch already running and do not wait for set_threads again.
+    void parallel_for(size_t count, const std::function<void(size_t begin, size_t end)>& f);
+
+  private:
+    threadpool();
+    ~threadpool();
+    threadpool(const threadpool&) = delete;
+    threadpool& operator=(const threadpool&) = delete;
+
+    // Tracks a group of submitted tasks. Only parallel_for submits, under the config lock of its
+    // outermost batch, so set_threads never rebuilds the queues while a task is pushed.
+    class waiter
+    {
+    public:
+      explicit waiter(threadpool& pool) : m_pool(pool), m_pending(0) {}
+      ~waiter() { wait(); }
+
+      void wait();
+
+    private:
+      friend class threadpool;
+      void inc() { ++m_pending; }
+      void dec();
+
+      threadpool& m_pool;
+      std::atomic<size_t> m_pending;
+      std::mutex m_mutex;
+      std::condition_variable m_cond;
+    };
+
+    void submit(waiter& w, job f);
+
+    struct task
+    {
+      job f;
+      waiter* w;
+    };
+
+    struct task_queue
+    {
+      std::mutex mutex;
+      std::deque<task> tasks;
+    };
+
+    void start(unsigned threads, bool pin_threads);
+    void stop();
+    void run(size_t index);
+    bool pop(size_t index, task& t);
+    bool run_one(size_t index);
+
+    std::shared_timed_mutex m_config_mutex;  // shared while a batch runs, unique while reconfiguring
+    std::vector<std::unique_ptr<task_queue>> m_queues;  // one per worker plus one for outside threads
+    std::vector<std::thread> m_workers;
+    unsigned m_threads;
+    std::atomic<size_t> m_next_queue;
+    std::atomic<size_t> m_queued;
+    std::mutex m_sleep_mutex;
+    std::condition_variable m_sleep_cond;
+    bool m_running;
+  };
+}
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <limits>
 #include <type_traits>
 #include <utility>
@@ -22,14 +25,6 @@ namespace tools {
         *dest++ = static_cast<char>(i);
     }
 
-    template<typename t_type>
-    std::string get_varint_data(const t_type& v)
-    {
-      std::stringstream ss;
-      write_varint(std::ostreambuf_iterator<char>(ss), v);
-      return ss.str();
-    }
-
     template<int bits, typename InputIt, typename T>
     typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value && 0 <= bits && bits <= std::numeric_limits<T>::digits, int>::type
     read_varint(InputIt &&first, InputIt &&last, T &i) {
@@ -59,4 +54,95 @@ namespace tools {
     int read_varint(InputIt &&first, InputIt &&last, T &i) {
         return read_varint<std::numeric_limits<T>::digits, InputIt, T>(std::move(first), std::move(last), i);
     }
+
+    // Bytes write_varint_to needs at most for a T
+    template<typename T>
+    struct varint_max_size {
+        static const size_t value = (std::numeric_limits<T>::digits + 6) / 7;
+    };
+
+    // write_varint into a buffer of at least varint_max_size<T> bytes, returns the bytes written
+    template<typename T>
+    typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value, size_t>::type
+    write_varint_to(uint8_t *dest, T i) {
+        uint8_t *p = dest;
+        write_varint(p, i);
+        return p - dest;
+    }
+
+    // read_varint over [pos, end), with the same results, value and end position, errors
+    // included. Values of one and two bytes are decoded directly, the first eight bytes of
+    // longer ones that cannot overflow there are gathered from a 64 bit load without a branch
+    // per byte.
+    template<int bits, typename T>
+    typename std::enable_if<std::is_integral<T>::value && std::is_unsigned<T>::value && 0 <= bits && bits <= std::numeric_limits<T>::digits, int>::type
+    read_varint_from(const uint8_t *&pos, const uint8_t *end, T &i) {
+        const size_t left = end - pos;
+        if (left >= 1 && pos[0] < 0x80 && bits >= 7) {
+            i = pos[0];
+            pos += 1;
+            return 1;
+        }
+        if (left >= 2 && pos[1] < 0x80 && bits >= 14) {
+            i = static_cast<T>((pos[0] & 0x7f) | (static_cast<unsigned>(pos[1]) << 7));
+            pos += 2;
+            return pos[-1] == 0 ? -2 : 2; // -2: Non-canonical representation.
+        }
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        if (left >= 8) {
+            uint64_t w;
+            memcpy(&w, pos, sizeof(w));
+            const uint64_t stops = ~w & 0x8080808080808080ull;
+            const int len = stops ? __builtin_ctzll(stops) / 8 + 1 : 8;
+            // values that may overflow T within the load go through the checks of the loop
+            if (stops ? 7 * len < bits : bits > 56) {
+                uint64_t x = w & (0x7f7f7f7f7f7f7f7full >> (64 - 8 * len));
+                x = ((x & 0x7f007f007f007f00ull) >> 1) | (x & 0x007f007f007f007full);
+                x = ((x & 0x3fff00003fff0000ull) >> 2) | (x & 0x00003fff00003fffull);
+                x = ((x & 0x0fffffff00000000ull) >> 4) | (x & 0x000000000fffffffull);
+                i = static_cast<T>(x);
+                if (stops) {
+                    pos += len;
+                    return len > 1 && pos[-1] == 0 ? -2 : len; // -2: Non-canonical representation.
+                }
+                // nine bytes or more: the load holds the low 56 bits, the bytes past it go
+                // through the checks of the loop one by one
+                const uint8_t *p = pos + 8;
+                int read = 8;
+                for (int shift = 56; read > 0; shift += 7) {
+                    if (p == end) {
+                        break; // End of input.
+                    }
+                    const uint8_t byte = *p++;
+                    ++read;
+                    if (shift + 7 >= bits && byte >= 1 << (bits - shift)) {
+                        read = -1; // Overflow.
+                    } else if (byte == 0) {
+                        read = -2; // Non-canonical representation.
+                    } else {
+                        i |= static_cast<T>(byte & 0x7f) << shift;
+                        if ((byte & 0x80) == 0) {
+                            break;
+                        }
+                    }
+                }
+                pos = p;
+                return read;
+            }
+        }
+#endif
+        return read_varint<bits>(pos, end, i);
+    }
+
+    template<typename T>
+    int read_varint_from(const uint8_t *&pos, const uint8_t *end, T &i) {
+        return read_varint_from<std::numeric_limits<T>::digits, T>(pos, end, i);
+    }
+
+    template<typename t_type>
+    std::string get_varint_data(const t_type& v)
+    {
+      uint8_t bytes[varint_max_size<t_type>::value];
+      return std::string(reinterpret_cast<const char*>(bytes), write_varint_to(bytes, v));
+    }
 }
@@ -53,6 +53,15 @@ enum {
 };
 
 void cn_fast_hash(const void *data, size_t length, char *hash);
+// cn_fast_hash of exactly 2 / 3 hashes
+void cn_fast_hash_64(const void *data, char *hash);
+void cn_fast_hash_96(const void *data, char *hash);
+// cn_fast_hash of 4 / 8 inputs of the same length, run side by side as keccak_simd_lanes allows
+void cn_fast_hash_x4(const void *const data[4], size_t length, char *const hash[4]);
+void cn_fast_hash_x8(const void *const data[8], size_t length, char *const hash[8]);
+// cn_fast_hash of count inputs of length bytes packed one after another; hashes may overlap
+// data as long as no hash lies past its own input, so a level of a tree can be hashed in place
+void cn_fast_hash_batch(const void *data, size_t length, size_t count, char (*hashes)[HASH_SIZE]);
 void cn_slow_hash(const void *data, size_t length, char *hash);
 
 void hash_extra_blake(const void *data, size_t length, char *hash);
@@ -63,4 +72,13 @@ void hash_extra_skein(const void *data, size_t length, char *hash);
 void tree_hash(const char (*hashes)[HASH_SIZE], size_t count, char *root_hash);
 size_t tree_depth(size_t count);
 void tree_branch(const char (*hashes)[HASH_SIZE], size_t count, char (*branch)[HASH_SIZE]);
+// Hashes tree_hash_scratch and tree_branch_scratch need in scratch for count leaves: the
+// largest power of two not above count. Each level is reduced in place over the one below,
+// so that is all the memory either needs. tree_hash and tree_branch take it from the stack
+// for small trees and from the heap for big ones.
+size_t tree_scratch_count(size_t count);
+// scratch hashes tree_hash and tree_branch keep on the stack (16 KB), enough below 1024 leaves
+#define TREE_STACK_HASHES 512
+void tree_hash_scratch(const char (*hashes)[HASH_SIZE], size_t count, char *root_hash, void *scratch);
+void tree_branch_scratch(const char (*hashes)[HASH_SIZE], size_t count, char (*branch)[HASH_SIZE], void *scratch);
 void tree_hash_from_branch(const char (*branch)[HASH_SIZE], size_t depth, const char *leaf, const void *path, char *root_hash);
@@ -22,3 +22,45 @@ void cn_fast_hash(const void *data, size_t length, char *hash) {
   hash_process(&state, data, length);
   memcpy(hash, &state, HASH_SIZE);
 }
+
+void cn_fast_hash_64(const void *data, char *hash) {
+  keccak_64(data, (uint8_t *) hash);
+}
+
+void cn_fast_hash_96(const void *data, char *hash) {
+  keccak_96(data, (uint8_t *) hash);
+}
+
+void cn_fast_hash_x4(const void *const data[4], size_t length, char *const hash[4]) {
+  keccak_x4((const uint8_t *const *) data, length, (uint8_t *const *) hash, HASH_SIZE);
+}
+
+void cn_fast_hash_x8(const void *const data[8], size_t length, char *const hash[8]) {
+  keccak_x8((const uint8_t *const *) data, length, (uint8_t *const *) hash, HASH_SIZE);
+}
+
+void cn_fast_hash_batch(const void *data, size_t length, size_t count, char (*hashes)[HASH_SIZE]) {
+  const char *in = data;
+  const int lanes = keccak_simd_lanes();
+  size_t i = 0;
+  for (; lanes >= 8 && count - i >= 8; i += 8) {
+    const void *lanes_in[8] = { in, in + length, in + 2 * length, in + 3 * length,
+                                in + 4 * length, in + 5 * length, in + 6 * length, in + 7 * length };
+    char *const lanes_out[8] = { hashes[i], hashes[i + 1], hashes[i + 2], hashes[i + 3],
+                                 hashes[i + 4], hashes[i + 5], hashes[i + 6], hashes[i + 7] };
+    cn_fast_hash_x8(lanes_in, length, lanes_out);
+    in += 8 * length;
+  }
+  for (; lanes >= 4 && count - i >= 4; i += 4) {
+    const void *lanes_in[4] = { in, in + length, in + 2 * length, in + 3 * length };
+    char *const lanes_out[4] = { hashes[i], hashes[i + 1], hashes[i + 2], hashes[i + 3] };
+    cn_fast_hash_x4(lanes_in, length, lanes_out);
+    in += 4 * length;
+  }
+  for (; i < count; ++i, in += length) {
+    if (length == 2 * HASH_SIZE)
+      cn_fast_hash_64(in, hashes[i]);
+    else
+      cn_fast_hash(in, length, hashes[i]);
+  }
+}
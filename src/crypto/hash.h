@@ -5,6 +5,7 @@
 #pragma once
 
 #include <stddef.h>
+#include <vector>
 
 #include "common/pod-class.h"
 #include "generic-ops.h"
@@ -53,17 +54,52 @@ namespace crypto {
     return h;
   }
 
+  inline hash cn_fast_hash_96(const hash (&hashes)[3]) {
+    hash h;
+    cn_fast_hash_96(hashes, reinterpret_cast<char *>(&h));
+    return h;
+  }
+
   inline void cn_slow_hash(const void *data, std::size_t length, hash &hash) {
     cn_slow_hash(data, length, reinterpret_cast<char *>(&hash));
   }
 
+  // scratch of the tree functions for trees past TREE_STACK_HASHES, per thread so big trees
+  // neither go on the stack of a worker nor allocate on every call
+  inline void *tree_scratch(std::size_t count) {
+    thread_local std::vector<hash> scratch;
+    const std::size_t needed = tree_scratch_count(count);
+    if (scratch.size() < needed)
+      scratch.resize(needed);
+    return scratch.data();
+  }
+
+  // trees from this many leaves up hash their wide levels across the thread pool
+  const std::size_t tree_hash_parallel_leaves = 4096;
+
+  // tree_hash with every level of at least 1024 pairs split across tools::threadpool
+  void tree_hash_parallel(const hash *hashes, std::size_t count, hash &root_hash);
+
   inline void tree_hash(const hash *hashes, std::size_t count, hash &root_hash) {
-    tree_hash(reinterpret_cast<const char (*)[HASH_SIZE]>(hashes), count, reinterpret_cast<char *>(&root_hash));
+    if (count >= tree_hash_parallel_leaves) {
+      tree_hash_parallel(hashes, count, root_hash);
+      return;
+    }
+    if (tree_scratch_count(count) <= TREE_STACK_HASHES) {
+      tree_hash(reinterpret_cast<const char (*)[HASH_SIZE]>(hashes), count, reinterpret_cast<char *>(&root_hash));
+      return;
+    }
+    tree_hash_scratch(reinterpret_cast<const char (*)[HASH_SIZE]>(hashes), count, reinterpret_cast<char *>(&root_hash), tree_scratch(count));
   }
 
   inline void tree_branch(const hash* hashes, std::size_t count, hash* branch)
   {
-    tree_branch(reinterpret_cast<const char (*)[HASH_SIZE]>(hashes), count, reinterpret_cast<char (*)[HASH_SIZE]>(branch));
+    if (tree_scratch_count(count) <= TREE_STACK_HASHES)
+    {
+      tree_branch(reinterpret_cast<const char (*)[HASH_SIZE]>(hashes), count, reinterpret_cast<char (*)[HASH_SIZE]>(branch));
+      return;
+    }
+    tree_branch_scratch(reinterpret_cast<const char (*)[HASH_SIZE]>(hashes), count, reinterpret_cast<char (*)[HASH_SIZE]>(branch), tree_scratch(count));
   }
 
   inline void tree_hash_from_branch(const hash* branch, std::size_t depth, const hash& leaf, const void* path, hash& root_hash)
@@ -0,0 +1,215 @@
+// Copyright (c) 2012-2013 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+// Keccak over several independent states at once. The states are interleaved word by word,
+// so word i of every state fills one SIMD register and each round step of keccakf runs on
+// all of them with one instruction.
+
+#include "hash-ops.h"
+#include "keccak.h"
+
+extern const uint64_t keccakf_rndc[24];
+
+#if KECCAK_DISPATCH
+
+typedef uint64_t keccak_v4 __attribute__((vector_size(32)));
+typedef uint64_t keccak_v8 __attribute__((vector_size(64)));
+
+#define ROTL_V(x, y) (((x) << (y)) | ((x) >> (64 - (y))))
+
+// one round, rho and pi unrolled with the rotation offsets of each word
+#define KECCAK_ROUND_V(a, b, c, d, rc) do { \
+    int i_; \
+    for (i_ = 0; i_ < 5; i_++) \
+        c[i_] = a[i_] ^ a[i_ + 5] ^ a[i_ + 10] ^ a[i_ + 15] ^ a[i_ + 20]; \
+    for (i_ = 0; i_ < 5; i_++) \
+        d[i_] = c[(i_ + 4) % 5] ^ ROTL_V(c[(i_ + 1) % 5], 1); \
+    for (i_ = 0; i_ < 25; i_++) \
+        a[i_] ^= d[i_ % 5]; \
+    b[ 0] = a[0]; \
+    b[ 1] = ROTL_V(a[6], 44); \
+    b[ 2] = ROTL_V(a[12], 43); \
+    b[ 3] = ROTL_V(a[18], 21); \
+    b[ 4] = ROTL_V(a[24], 14); \
+    b[ 5] = ROTL_V(a[3], 28); \
+    b[ 6] = ROTL_V(a[9], 20); \
+    b[ 7] = ROTL_V(a[10], 3); \
+    b[ 8] = ROTL_V(a[16], 45); \
+    b[ 9] = ROTL_V(a[22], 61); \
+    b[10] = ROTL_V(a[1], 1); \
+    b[11] = ROTL_V(a[7], 6); \
+    b[12] = ROTL_V(a[13], 25); \
+    b[13] = ROTL_V(a[19], 8); \
+    b[14] = ROTL_V(a[20], 18); \
+    b[15] = ROTL_V(a[4], 27); \
+    b[16] = ROTL_V(a[5], 36); \
+    b[17] = ROTL_V(a[11], 10); \
+    b[18] = ROTL_V(a[17], 15); \
+    b[19] = ROTL_V(a[23], 56); \
+    b[20] = ROTL_V(a[2], 62); \
+    b[21] = ROTL_V(a[8], 55); \
+    b[22] = ROTL_V(a[14], 39); \
+    b[23] = ROTL_V(a[15], 41); \
+    b[24] = ROTL_V(a[21], 2); \
+    for (i_ = 0; i_ < 25; i_ += 5) { \
+        a[i_ + 0] = b[i_ + 0] ^ (~b[i_ + 1] & b[i_ + 2]); \
+        a[i_ + 1] = b[i_ + 1] ^ (~b[i_ + 2] & b[i_ + 3]); \
+        a[i_ + 2] = b[i_ + 2] ^ (~b[i_ + 3] & b[i_ + 4]); \
+        a[i_ + 3] = b[i_ + 3] ^ (~b[i_ + 4] & b[i_ + 0]); \
+        a[i_ + 4] = b[i_ + 4] ^ (~b[i_ + 0] & b[i_ + 1]); \
+    } \
+    a[0] ^= (rc); \
+} while (0)
+
+__attribute__((target("avx2")))
+static void keccakf_x4_avx2(uint64_t st[25 * 4], int rounds)
+{
+    keccak_v4 a[25], b[25], c[5], d[5];
+    int round;
+
+    memcpy(a, st, sizeof(a));
+    for (round = 0; round < rounds; round++)
+        KECCAK_ROUND_V(a, b, c, d, keccakf_rndc[round]);
+    memcpy(st, a, sizeof(a));
+}
+
+__attribute__((target("avx512f")))
+static void keccakf_x8_avx512(uint64_t st[25 * 8], int rounds)
+{
+    keccak_v8 a[25], b[25], c[5], d[5];
+    int round;
+
+    memcpy(a, st, sizeof(a));
+    for (round = 0; round < rounds; round++)
+        KECCAK_ROUND_V(a, b, c, d, keccakf_rndc[round]);
+    memcpy(st, a, sizeof(a));
+}
+
+#endif
+
+// without SIMD registers of the width the states go through keccakf one after another
+static void keccakf_each(uint64_t *st, int lanes, int rounds)
+{
+    state_t s;
+    int i, l;
+
+    for (l = 0; l < lanes; l++) {
+        for (i = 0; i < 25; i++)
+            s[i] = st[i * lanes + l];
+        keccakf(s, rounds);
+        for (i = 0; i < 25; i++)
+            st[i * lanes + l] = s[i];
+    }
+}
+
+static void keccakf_x4_each(uint64_t st[25 * 4], int rounds)
+{
+    keccakf_each(st, 4, rounds);
+}
+
+static void keccakf_x8_each(uint64_t st[25 * 8], int rounds)
+{
+    keccakf_each(st, 8, rounds);
+}
+
+static void (*keccakf_x4_impl)(uint64_t st[25 * 4], int rounds) = keccakf_x4_each;
+static void (*keccakf_x8_impl)(uint64_t st[25 * 8], int rounds) = keccakf_x8_each;
+static int keccakf_lanes = 1;
+
+#if KECCAK_DISPATCH
+__attribute__((constructor))
+static void keccakf_lanes_select(void)
+{
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        keccakf_x4_impl = keccakf_x4_avx2;
+        keccakf_lanes = 4;
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        keccakf_x8_impl = keccakf_x8_avx512;
+        keccakf_lanes = 8;
+    }
+}
+#endif
+
+int keccak_simd_lanes(void)
+{
+    return keccakf_lanes;
+}
+
+void keccakf_x4(uint64_t st[25 * 4], int rounds)
+{
+    keccakf_x4_impl(st, rounds);
+}
+
+void keccakf_x8(uint64_t st[25 * 8], int rounds)
+{
+    keccakf_x8_impl(st, rounds);
+}
+
+// keccak() for lanes inputs of the same length
+static void keccak_interleaved(const uint8_t *const *in, size_t inlen, uint8_t *const *md, int mdlen,
+                         int lanes, uint64_t *st, void (*permute)(uint64_t *, int))
+{
+    uint64_t temp[144 / 8];
+    size_t offset = 0;
+    int i, l, rsiz, rsizw;
+
+    rsiz = sizeof(state_t) == mdlen ? HASH_DATA_AREA : 200 - 2 * mdlen;
+    rsizw = rsiz / 8;
+
+    memset(st, 0, 25 * lanes * sizeof(uint64_t));
+
+    for ( ; inlen - offset >= (size_t) rsiz; offset += rsiz) {
+        for (l = 0; l < lanes; l++) {
+            memcpy(temp, in[l] + offset, rsiz);
+            for (i = 0; i < rsizw; i++)
+                st[i * lanes + l] ^= temp[i];
+        }
+        permute(st, KECCAK_ROUNDS);
+    }
+
+    // last block and padding, the same for every lane; whole words, as the 64 byte halves
+    // of tree hashing, go straight into the state with the padding as two constant XORs
+    for (l = 0; l < lanes; l++) {
+        const size_t rest = inlen - offset;
+        if (rest % 8 == 0) {
+            for (i = 0; i < (int) (rest / 8); i++) {
+                uint64_t w;
+                memcpy(&w, in[l] + offset + i * 8, 8);
+                st[i * lanes + l] ^= w;
+            }
+            st[i * lanes + l] ^= 1;
+            st[(rsizw - 1) * lanes + l] ^= 0x8000000000000000ULL;
+            continue;
+        }
+        memcpy(temp, in[l] + offset, rest);
+        ((uint8_t *) temp)[rest] = 1;
+        memset((uint8_t *) temp + rest + 1, 0, rsiz - rest - 1);
+        ((uint8_t *) temp)[rsiz - 1] |= 0x80;
+        for (i = 0; i < rsizw; i++)
+            st[i * lanes + l] ^= temp[i];
+    }
+
+    permute(st, KECCAK_ROUNDS);
+
+    for (l = 0; l < lanes; l++) {
+        state_t s;
+        for (i = 0; i < 25; i++)
+            s[i] = st[i * lanes + l];
+        memcpy(md[l], s, mdlen);
+    }
+}
+
+void keccak_x4(const uint8_t *const in[4], size_t inlen, uint8_t *const md[4], int mdlen)
+{
+    uint64_t st[25 * 4];
+    keccak_interleaved(in, inlen, md, mdlen, 4, st, keccakf_x4);
+}
+
+void keccak_x8(const uint8_t *const in[8], size_t inlen, uint8_t *const md[8], int mdlen)
+{
+    uint64_t st[25 * 8];
+    keccak_interleaved(in, inlen, md, mdlen, 8, st, keccakf_x8);
+}
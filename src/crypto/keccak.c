@@ -17,62 +17,93 @@ const uint64_t keccakf_rndc[24] =
     0x8000000000008080, 0x0000000080000001, 0x8000000080008008
 };
 
-const int keccakf_rotc[24] = 
-{
-    1,  3,  6,  10, 15, 21, 28, 36, 45, 55, 2,  14, 
-    27, 41, 56, 8,  25, 43, 62, 18, 39, 61, 20, 44
-};
-
-const int keccakf_piln[24] = 
-{
-    10, 7,  11, 17, 18, 3, 5,  16, 8,  21, 24, 4, 
-    15, 23, 19, 13, 12, 2, 20, 14, 22, 9,  6,  1 
-};
+// keccakf round on a state with lanes 1, 2, 8, 12, 17 and 20 kept complemented, which
+// leaves chi one NOT per row instead of five (lane complementing, as in the Keccak team's
+// optimized 64 bit code)
+#define KECCAK_ROUND(a, b, c, d, rc) do { \
+    c[0] = a[0] ^ a[5] ^ a[10] ^ a[15] ^ a[20]; \
+    c[1] = a[1] ^ a[6] ^ a[11] ^ a[16] ^ a[21]; \
+    c[2] = a[2] ^ a[7] ^ a[12] ^ a[17] ^ a[22]; \
+    c[3] = a[3] ^ a[8] ^ a[13] ^ a[18] ^ a[23]; \
+    c[4] = a[4] ^ a[9] ^ a[14] ^ a[19] ^ a[24]; \
+    d[0] = c[4] ^ ROTL64(c[1], 1); \
+    d[1] = c[0] ^ ROTL64(c[2], 1); \
+    d[2] = c[1] ^ ROTL64(c[3], 1); \
+    d[3] = c[2] ^ ROTL64(c[4], 1); \
+    d[4] = c[3] ^ ROTL64(c[0], 1); \
+    b[ 0] = a[0] ^ d[0]; \
+    b[ 1] = ROTL64(a[6] ^ d[1], 44); \
+    b[ 2] = ROTL64(a[12] ^ d[2], 43); \
+    b[ 3] = ROTL64(a[18] ^ d[3], 21); \
+    b[ 4] = ROTL64(a[24] ^ d[4], 14); \
+    b[ 5] = ROTL64(a[3] ^ d[3], 28); \
+    b[ 6] = ROTL64(a[9] ^ d[4], 20); \
+    b[ 7] = ROTL64(a[10] ^ d[0], 3); \
+    b[ 8] = ROTL64(a[16] ^ d[1], 45); \
+    b[ 9] = ROTL64(a[22] ^ d[2], 61); \
+    b[10] = ROTL64(a[1] ^ d[1], 1); \
+    b[11] = ROTL64(a[7] ^ d[2], 6); \
+    b[12] = ROTL64(a[13] ^ d[3], 25); \
+    b[13] = ROTL64(a[19] ^ d[4], 8); \
+    b[14] = ROTL64(a[20] ^ d[0], 18); \
+    b[15] = ROTL64(a[4] ^ d[4], 27); \
+    b[16] = ROTL64(a[5] ^ d[0], 36); \
+    b[17] = ROTL64(a[11] ^ d[1], 10); \
+    b[18] = ROTL64(a[17] ^ d[2], 15); \
+    b[19] = ROTL64(a[23] ^ d[3], 56); \
+    b[20] = ROTL64(a[2] ^ d[2], 62); \
+    b[21] = ROTL64(a[8] ^ d[3], 55); \
+    b[22] = ROTL64(a[14] ^ d[4], 39); \
+    b[23] = ROTL64(a[15] ^ d[0], 41); \
+    b[24] = ROTL64(a[21] ^ d[1], 2); \
+    a[ 0] = b[0] ^ (b[1] | b[2]) ^ (rc); \
+    a[ 1] = b[1] ^ (~b[2] | b[3]); \
+    a[ 2] = b[2] ^ (b[3] & b[4]); \
+    a[ 3] = b[3] ^ (b[4] | b[0]); \
+    a[ 4] = b[4] ^ (b[0] & b[1]); \
+    a[ 5] = b[5] ^ (b[6] | b[7]); \
+    a[ 6] = b[6] ^ (b[7] & b[8]); \
+    a[ 7] = b[7] ^ (b[8] | ~b[9]); \
+    a[ 8] = b[8] ^ (b[9] | b[5]); \
+    a[ 9] = b[9] ^ (b[5] & b[6]); \
+    a[10] = b[10] ^ (b[11] | b[12]); \
+    a[11] = b[11] ^ (b[12] & b[13]); \
+    a[12] = b[12] ^ (~b[13] & b[14]); \
+    a[13] = ~b[13] ^ (b[14] | b[10]); \
+    a[14] = b[14] ^ (b[10] & b[11]); \
+    a[15] = b[15] ^ (b[16] & b[17]); \
+    a[16] = b[16] ^ (b[17] | b[18]); \
+    a[17] = b[17] ^ (~b[18] | b[19]); \
+    a[18] = ~b[18] ^ (b[19] & b[15]); \
+    a[19] = b[19] ^ (b[15] | b[16]); \
+    a[20] = b[20] ^ (~b[21] & b[22]); \
+    a[21] = ~b[21] ^ (b[22] | b[23]); \
+    a[22] = b[22] ^ (b[23] & b[24]); \
+    a[23] = b[23] ^ (b[24] | b[20]); \
+    a[24] = b[24] ^ (b[20] & b[21]); \
+} while (0)
+
+#if defined(__GNUC__)
+#define KECCAK_ALWAYS_INLINE static inline __attribute__((always_inline))
+#else
+#define KECCAK_ALWAYS_INLINE static inline
+#endif
 
 // update the state with given number of rounds
-
 void keccakf(uint64_t st[25], int rounds)
 {
-    int i, j, round;
-    uint64_t t, bc[5];
-
-    for (round = 0; round < rounds; round++) {
-
-        // Theta
-        for (i = 0; i < 5; i++)     
-            bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
-
-        for (i = 0; i < 5; i++) {
-            t = bc[(i + 4) % 5] ^ ROTL64(bc[(i + 1) % 5], 1);
-            for (j = 0; j < 25; j += 5)
-                st[j + i] ^= t;
-        }
-
-        // Rho Pi
-        t = st[1];
-        for (i = 0; i < 24; i++) {
-            j = keccakf_piln[i];
-            bc[0] = st[j];
-            st[j] = ROTL64(t, keccakf_rotc[i]);
-            t = bc[0];
-        }
-
-        //  Chi
-        for (j = 0; j < 25; j += 5) {
-            for (i = 0; i < 5; i++)
-                bc[i] = st[j + i];
-            for (i = 0; i < 5; i++)
-                st[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
-        }
-
-        //  Iota
-        st[0] ^= keccakf_rndc[round];
-    }
+    uint64_t a[25], b[25], c[5], d[5];
+    int round;
+
+    memcpy(a, st, sizeof(a));
+    a[1] = ~a[1]; a[2] = ~a[2]; a[8] = ~a[8]; a[12] = ~a[12]; a[17] = ~a[17]; a[20] = ~a[20];
+    for (round = 0; round < rounds; round++)
+        KECCAK_ROUND(a, b, c, d, keccakf_rndc[round]);
+    a[1] = ~a[1]; a[2] = ~a[2]; a[8] = ~a[8]; a[12] = ~a[12]; a[17] = ~a[17]; a[20] = ~a[20];
+    memcpy(st, a, sizeof(a));
 }
 
 // compute a keccak hash (md) of given byte length from "in"
-typedef uint64_t state_t[25];
-
 int keccak(const uint8_t *in, int inlen, uint8_t *md, int mdlen)
 {
     state_t st;
@@ -110,3 +141,82 @@ void keccak1600(const uint8_t *in, int inlen, uint8_t *md)
 {
     keccak(in, inlen, md, sizeof(state_t));
 }
+
+// keccak1600 of words 64 bit words, one block: the input is loaded straight into the state
+// and the padding of keccak1600 lands on two whole words, so it folds into two constant XORs
+KECCAK_ALWAYS_INLINE void keccak_words(const uint8_t *in, int words, uint8_t *md)
+{
+    state_t st;
+
+    memcpy(st, in, words * 8);
+    memset(st + words, 0, sizeof(st) - words * 8);
+    st[words] = 1;
+    st[HASH_DATA_AREA / 8 - 1] |= 0x8000000000000000ULL;
+
+    keccakf(st, KECCAK_ROUNDS);
+
+    memcpy(md, st, 32);
+}
+
+void keccak_64(const uint8_t *in, uint8_t *md)
+{
+    keccak_words(in, 8, md);
+}
+
+void keccak_96(const uint8_t *in, uint8_t *md)
+{
+    keccak_words(in, 12, md);
+}
+
+void keccak_init(keccak_ctx *ctx)
+{
+    memset(ctx->st, 0, sizeof(ctx->st));
+    ctx->rest = 0;
+}
+
+void keccak_absorb(keccak_ctx *ctx, const uint8_t *in, size_t inlen)
+{
+    int i;
+
+    if (ctx->rest) {
+        size_t left = KECCAK_BLOCKLEN - ctx->rest;
+        if (inlen < left) {
+            memcpy(ctx->buf + ctx->rest, in, inlen);
+            ctx->rest += inlen;
+            return;
+        }
+        memcpy(ctx->buf + ctx->rest, in, left);
+        in += left;
+        inlen -= left;
+        for (i = 0; i < KECCAK_BLOCKLEN / 8; i++)
+            ctx->st[i] ^= ((uint64_t *) ctx->buf)[i];
+        keccakf(ctx->st, KECCAK_ROUNDS);
+        ctx->rest = 0;
+    }
+
+    for ( ; inlen >= KECCAK_BLOCKLEN; inlen -= KECCAK_BLOCKLEN, in += KECCAK_BLOCKLEN) {
+        for (i = 0; i < KECCAK_BLOCKLEN / 8; i++)
+            ctx->st[i] ^= ((uint64_t *) in)[i];
+        keccakf(ctx->st, KECCAK_ROUNDS);
+    }
+
+    memcpy(ctx->buf, in, inlen);
+    ctx->rest = inlen;
+}
+
+void keccak_finalize(keccak_ctx *ctx, uint8_t *md)
+{
+    int i;
+
+    // last block and padding, same as keccak()
+    ctx->buf[ctx->rest++] = 1;
+    memset(ctx->buf + ctx->rest, 0, KECCAK_BLOCKLEN - ctx->rest);
+    ctx->buf[KECCAK_BLOCKLEN - 1] |= 0x80;
+
+    for (i = 0; i < KECCAK_BLOCKLEN / 8; i++)
+        ctx->st[i] ^= ((uint64_t *) ctx->buf)[i];
+
+    keccakf(ctx->st, KECCAK_ROUNDS);
+
+    memcpy(md, ctx->st, sizeof(state_t));
+}
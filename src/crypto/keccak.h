@@ -15,6 +15,26 @@
 #define ROTL64(x, y) (((x) << (y)) | ((x) >> (64 - (y))))
 #endif
 
+#define KECCAK_BLOCKLEN 136
+
+typedef uint64_t state_t[25];
+
+// x86 builds target the baseline ISA and pick the keccakf_x4 / keccakf_x8 variants for the
+// CPU at load time
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KECCAK_DISPATCH 1
+#else
+#define KECCAK_DISPATCH 0
+#endif
+
+// incremental keccak1600 for data that is hashed in pieces; a context copy
+// taken after keccak_absorb() can be resumed any number of times
+typedef struct {
+    state_t st;
+    uint8_t buf[KECCAK_BLOCKLEN];
+    size_t rest;
+} keccak_ctx;
+
 // compute a keccak hash (md) of given byte length from "in"
 int keccak(const uint8_t *in, int inlen, uint8_t *md, int mdlen);
 
@@ -23,4 +43,26 @@ void keccakf(uint64_t st[25], int norounds);
 
 void keccak1600(const uint8_t *in, int inlen, uint8_t *md);
 
+// keccak1600 of exactly 64 / 96 bytes, the two and three hash inputs of tree and tx hashes;
+// writes the first 32 bytes of the state
+void keccak_64(const uint8_t *in, uint8_t *md);
+void keccak_96(const uint8_t *in, uint8_t *md);
+
+// keccakf on 4 / 8 states interleaved by word, word i of state l at st[i * lanes + l]; the
+// states share SIMD registers when the CPU has AVX2 / AVX-512, else they take turns
+void keccakf_x4(uint64_t st[25 * 4], int norounds);
+void keccakf_x8(uint64_t st[25 * 8], int norounds);
+// most states keccakf_x4 / keccakf_x8 permute side by side on this CPU: 8, 4 or 1
+int keccak_simd_lanes(void);
+
+// keccak() of 4 / 8 inputs of the same length; all input is read before md is written,
+// so md may overlap it
+void keccak_x4(const uint8_t *const in[4], size_t inlen, uint8_t *const md[4], int mdlen);
+void keccak_x8(const uint8_t *const in[8], size_t inlen, uint8_t *const md[8], int mdlen);
+
+void keccak_init(keccak_ctx *ctx);
+void keccak_absorb(keccak_ctx *ctx, const uint8_t *in, size_t inlen);
+// writes the whole 200 byte state, cn_fast_hash uses the first HASH_SIZE bytes
+void keccak_finalize(keccak_ctx *ctx, uint8_t *md);
+
 #endif
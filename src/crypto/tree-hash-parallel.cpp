@@ -0,0 +1,60 @@
+// Copyright (c) 2012-2013 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "common/thread_pool.h"
+#include "hash.h"
+
+namespace crypto
+{
+  namespace
+  {
+    // levels narrower than this many pairs are not worth a round trip through the pool
+    const size_t tree_parallel_pairs = 1024;
+    // pairs per task unit, one full 8 lane keccak batch
+    const size_t tree_unit = 8;
+
+    // out[i] = hash of in[2i] and in[2i + 1] for i < pairs, split across the pool. Tasks write
+    // a level other than the one they read, so they can not overwrite each other's input.
+    void hash_level(const hash *in, size_t pairs, hash *out)
+    {
+      tools::threadpool::instance().parallel_for((pairs + tree_unit - 1) / tree_unit, [in, pairs, out](size_t begin, size_t end) {
+        begin *= tree_unit;
+        end = std::min(end * tree_unit, pairs);
+        cn_fast_hash_batch(in + 2 * begin, 2 * HASH_SIZE, end - begin, reinterpret_cast<char (*)[HASH_SIZE]>(out + begin));
+      });
+    }
+  }
+
+  void tree_hash_parallel(const hash *hashes, std::size_t count, hash &root_hash)
+  {
+    if (count < 3)
+    {
+      tree_hash(reinterpret_cast<const char (*)[HASH_SIZE]>(hashes), count, reinterpret_cast<char *>(&root_hash));
+      return;
+    }
+
+    // same shape as tree_hash: the leaves past the largest power of two below count are
+    // paired first, the ones before it move up a level unhashed
+    size_t cnt = tree_scratch_count(count - 1);
+    std::vector<hash> level(cnt), next(cnt / 2);
+    memcpy(level.data(), hashes, (2 * cnt - count) * sizeof(hash));
+    hash_level(hashes + 2 * cnt - count, count - cnt, level.data() + 2 * cnt - count);
+    while (cnt > 2 && cnt / 2 >= tree_parallel_pairs)
+    {
+      cnt >>= 1;
+      hash_level(level.data(), cnt, next.data());
+      level.swap(next);
+    }
+    while (cnt > 2)
+    {
+      cnt >>= 1;
+      cn_fast_hash_batch(level.data(), 2 * HASH_SIZE, cnt, reinterpret_cast<char (*)[HASH_SIZE]>(level.data()));
+    }
+    cn_fast_hash_64(level.data(), reinterpret_cast<char *>(&root_hash));
+  }
+}
@@ -2,40 +2,59 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
-#include <alloca.h>
 #include <assert.h>
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "hash-ops.h"
 
+size_t tree_scratch_count(size_t count) {
+  size_t i;
+  assert(count > 0);
+  for (i = 1; i < sizeof(size_t) << 3; i <<= 1) {
+    count |= count >> i;
+  }
+  return count & ~(count >> 1);
+}
+
+static void *tree_scratch_alloc(size_t count, void *stack) {
+  void *scratch;
+  if (tree_scratch_count(count) <= TREE_STACK_HASHES) {
+    return stack;
+  }
+  scratch = malloc(tree_scratch_count(count) * HASH_SIZE);
+  if (scratch == NULL) {
+    abort();
+  }
+  return scratch;
+}
+
 void tree_hash(const char (*hashes)[HASH_SIZE], size_t count, char *root_hash) {
+  char stack[TREE_STACK_HASHES][HASH_SIZE];
+  void *scratch = tree_scratch_alloc(count, stack);
+  tree_hash_scratch(hashes, count, root_hash, scratch);
+  if (scratch != stack) {
+    free(scratch);
+  }
+}
+
+void tree_hash_scratch(const char (*hashes)[HASH_SIZE], size_t count, char *root_hash, void *scratch) {
   assert(count > 0);
   if (count == 1) {
     memcpy(root_hash, hashes, HASH_SIZE);
   } else if (count == 2) {
-    cn_fast_hash(hashes, 2 * HASH_SIZE, root_hash);
+    cn_fast_hash_64(hashes, root_hash);
   } else {
-    size_t i, j;
-    size_t cnt = count - 1;
-    char (*ints)[HASH_SIZE];
-    for (i = 1; i < sizeof(size_t) << 3; i <<= 1) {
-      cnt |= cnt >> i;
-    }
-    cnt &= ~(cnt >> 1);
-    ints = alloca(cnt * HASH_SIZE);
+    size_t cnt = tree_scratch_count(count - 1);
+    char (*ints)[HASH_SIZE] = scratch;
     memcpy(ints, hashes, (2 * cnt - count) * HASH_SIZE);
-    for (i = 2 * cnt - count, j = 2 * cnt - count; j < cnt; i += 2, ++j) {
-      cn_fast_hash(hashes[i], 2 * HASH_SIZE, ints[j]);
-    }
-    assert(i == count);
+    cn_fast_hash_batch(hashes[2 * cnt - count], 2 * HASH_SIZE, count - cnt, ints + 2 * cnt - count);
     while (cnt > 2) {
       cnt >>= 1;
-      for (i = 0, j = 0; j < cnt; i += 2, ++j) {
-        cn_fast_hash(ints[i], 64, ints[j]);
-      }
+      cn_fast_hash_batch(ints, 2 * HASH_SIZE, cnt, ints);
     }
-    cn_fast_hash(ints[0], 2 * HASH_SIZE, root_hash);
+    cn_fast_hash_64(ints[0], root_hash);
   }
 }
 
@@ -57,10 +76,21 @@ size_t tree_depth(size_t count)
 
 void tree_branch(const char (*hashes)[HASH_SIZE], size_t count, char (*branch)[HASH_SIZE])
 {
-  size_t i, j;
+  char stack[TREE_STACK_HASHES][HASH_SIZE];
+  void *scratch = tree_scratch_alloc(count, stack);
+  tree_branch_scratch(hashes, count, branch, scratch);
+  if (scratch != stack)
+  {
+    free(scratch);
+  }
+}
+
+void tree_branch_scratch(const char (*hashes)[HASH_SIZE], size_t count, char (*branch)[HASH_SIZE], void *scratch)
+{
+  size_t i;
   size_t cnt = 1;
   size_t depth = 0;
-  char (*ints)[HASH_SIZE];
+  char (*ints)[HASH_SIZE] = scratch;
   assert(count > 0);
   for (i = sizeof(size_t) << 2; i > 0; i >>= 1)
   {
@@ -72,23 +102,15 @@ void tree_branch(const char (*hashes)[HASH_SIZE], size_t count, char (*branch)[H
   }
   assert(cnt == 1ULL << depth);
   assert(depth == tree_depth(count));
-  ints = alloca((cnt - 1) * HASH_SIZE);
   memcpy(ints, hashes + 1, (2 * cnt - count - 1) * HASH_SIZE);
-  for (i = 2 * cnt - count, j = 2 * cnt - count - 1; j < cnt - 1; i += 2, ++j)
-  {
-    cn_fast_hash(hashes[i], 2 * HASH_SIZE, ints[j]);
-  }
-  assert(i == count);
+  cn_fast_hash_batch(hashes[2 * cnt - count], 2 * HASH_SIZE, count - cnt, ints + 2 * cnt - count - 1);
   while (depth > 0)
   {
     assert(cnt == 1ULL << depth);
     cnt >>= 1;
     --depth;
     memcpy(branch[depth], ints[0], HASH_SIZE);
-    for (i = 1, j = 0; j < cnt - 1; i += 2, ++j)
-    {
-      cn_fast_hash(ints[i], 2 * HASH_SIZE, ints[j]);
-    }
+    cn_fast_hash_batch(ints[1], 2 * HASH_SIZE, cnt - 1, ints);
   }
 }
 
@@ -123,10 +145,10 @@ void tree_hash_from_branch(const char (*branch)[HASH_SIZE], size_t depth, const
       }
       else
       {
-        cn_fast_hash(buffer, 2 * HASH_SIZE, leaf_path);
+        cn_fast_hash_64(buffer, leaf_path);
       }
       memcpy(branch_path, branch[depth], HASH_SIZE);
     }
-    cn_fast_hash(buffer, 2 * HASH_SIZE, root_hash);
+    cn_fast_hash_64(buffer, root_hash);
   }
 }
\ No newline at end of file
@@ -17,6 +17,7 @@
 #include "serialization/crypto.h"
 #include "serialization/pricing_record.h"
 #include "serialization/zephyr_pricing_record.h"
+#include "serialization/lazy_field.h"
 #include "serialization/keyvalue_serialization.h" // eepe named serialization
 #include "string_tools.h"
 #include "cryptonote_config.h"
@@ -482,6 +483,7 @@ namespace cryptonote
     };
 
     BEGIN_SERIALIZE()
+      const enum BLOB_TYPE blob_type = this->blob_type;
       if (blob_type == BLOB_TYPE_CRYPTONOTE_XHV) {
         VARINT_FIELD(version)
           //if(version == 0 || CURRENT_TRANSACTION_VERSION < version) return false;
@@ -809,6 +811,7 @@ namespace cryptonote
     void set_null();
 
     BEGIN_SERIALIZE_OBJECT()
+      const enum BLOB_TYPE blob_type = this->blob_type;
       FIELDS(*static_cast<transaction_prefix *>(this))
 
       if (version == 1 && blob_type != BLOB_TYPE_CRYPTONOTE2 && blob_type != BLOB_TYPE_CRYPTONOTE3)
@@ -912,11 +915,14 @@ namespace cryptonote
     unlock_time = 0;
     vin.clear();
     vin_zephyr.clear();
+    vin_salvium.clear();
     vout.clear();
     vout_xhv.clear();
     vout_zephyr.clear();
+    vout_salvium.clear();
     extra.clear();
     signatures.clear();
+    rct_signatures.type = rct::RCTTypeNull;
     pricing_record_height = 0;
     offshore_data.clear();
     amount_burnt = 0;
@@ -1067,15 +1073,21 @@ namespace cryptonote
     crypto::hash prev_id;
     uint64_t nonce;
     uint64_t nonce8;
-    offshore::pricing_record pricing_record;
-    zephyr_oracle::pricing_record zephyr_pricing_record;
-    salvium_oracle::pricing_record salvium_pricing_record;
-    crypto::cycle cycle;
-    crypto::cycle40 cycle40;
-    crypto::cycle48 cycle48;
+    tools::lazy_field<offshore::pricing_record> pricing_record;
+    tools::lazy_field<zephyr_oracle::pricing_record> zephyr_pricing_record;
+    tools::lazy_field<salvium_oracle::pricing_record> salvium_pricing_record;
+    // a blob type has at most one of the cycles, the largest one comes first so value
+    // initialization zeroes all of them
+    union
+    {
+      crypto::cycle48 cycle48;
+      crypto::cycle40 cycle40;
+      crypto::cycle cycle;
+    };
     crypto::signature signature;
 
     BEGIN_SERIALIZE()
+      const enum BLOB_TYPE blob_type = this->blob_type;
       VARINT_FIELD(major_version)
       VARINT_FIELD(minor_version)
       if (blob_type != BLOB_TYPE_FORKNOTE2) VARINT_FIELD(timestamp)
@@ -1109,11 +1121,11 @@ namespace cryptonote
           if (!typename Archive<W>::is_saving())
           {
             FIELD(pr_v3)
-            pr_v3.write_to_pr(zephyr_pricing_record);
+            pr_v3.write_to_pr(*zephyr_pricing_record);
           }
           else
           {
-            pr_v3.read_from_pr(zephyr_pricing_record);
+            pr_v3.read_from_pr(*zephyr_pricing_record);
             FIELD(pr_v3)
           }
         }
@@ -1123,11 +1135,11 @@ namespace cryptonote
           if (!typename Archive<W>::is_saving())
           {
             FIELD(pr_v2)
-            pr_v2.write_to_pr(zephyr_pricing_record);
+            pr_v2.write_to_pr(*zephyr_pricing_record);
           }
           else
           {
-            pr_v2.read_from_pr(zephyr_pricing_record);
+            pr_v2.read_from_pr(*zephyr_pricing_record);
             FIELD(pr_v2)
           }
         }
@@ -1137,11 +1149,11 @@ namespace cryptonote
           if (!typename Archive<W>::is_saving())
           {
             FIELD(pr_v1)
-            pr_v1.write_to_pr(zephyr_pricing_record);
+            pr_v1.write_to_pr(*zephyr_pricing_record);
           }
           else
           {
-            pr_v1.read_from_pr(zephyr_pricing_record);
+            pr_v1.read_from_pr(*zephyr_pricing_record);
             FIELD(pr_v1)
           }
         }
@@ -1153,16 +1165,21 @@ namespace cryptonote
 
   struct block: public block_header
   {
-    bytecoin_block parent_block;
+    tools::lazy_field<bytecoin_block> parent_block;
 
     transaction miner_tx;
-    transaction protocol_tx;
+    tools::lazy_field<transaction> protocol_tx;
     std::vector<crypto::hash> tx_hashes;
     mutable crypto::hash uncle = cryptonote::null_hash;
 
-    void set_blob_type(enum BLOB_TYPE bt) { miner_tx.blob_type = protocol_tx.blob_type = blob_type = bt; }
+    void set_blob_type(enum BLOB_TYPE bt)
+    {
+      miner_tx.blob_type = blob_type = bt;
+      if (bt == BLOB_TYPE_CRYPTONOTE_SALVIUM) protocol_tx->blob_type = bt;
+    }
 
     BEGIN_SERIALIZE_OBJECT()
+      const enum BLOB_TYPE blob_type = this->blob_type;
       FIELDS(*static_cast<block_header *>(this))
       if (blob_type == BLOB_TYPE_FORKNOTE2)
       {
@@ -1185,7 +1202,7 @@ namespace cryptonote
   inline serializable_bytecoin_block make_serializable_bytecoin_block(const block& b, bool hashing_serialization, bool header_only)
   {
     block& block_ref = const_cast<block&>(b);
-    return serializable_bytecoin_block(block_ref.parent_block, block_ref.timestamp, hashing_serialization, header_only);
+    return serializable_bytecoin_block(*block_ref.parent_block, block_ref.timestamp, hashing_serialization, header_only);
   }
 
   /************************************************************************/
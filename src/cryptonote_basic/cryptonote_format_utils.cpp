@@ -12,17 +12,24 @@ using namespace epee;
 #include "crypto/crypto.h"
 #include "crypto/hash.h"
 #include "serialization/binary_utils.h"
+#include "serialization/binary_hashing_archive.h"
 
 namespace cryptonote
 {
   //---------------------------------------------------------------
-  void get_transaction_prefix_hash(const transaction_prefix& tx, crypto::hash& h)
+  static void get_transaction_prefix_hashing_blob(const transaction_prefix& tx, blobdata& blob)
   {
-    std::ostringstream s;
-    if (tx.blob_type == BLOB_TYPE_CRYPTONOTE_RYO) s << "ryo-currency";
-    binary_archive<true> a(s);
+    blob.clear();
+    if (tx.blob_type == BLOB_TYPE_CRYPTONOTE_RYO) blob = "ryo-currency";
+    binary_archive<true> a(blob);
     ::serialization::serialize(a, const_cast<transaction_prefix&>(tx));
-    crypto::cn_fast_hash(s.str().data(), s.str().size(), h);
+  }
+  //---------------------------------------------------------------
+  void get_transaction_prefix_hash(const transaction_prefix& tx, crypto::hash& h)
+  {
+    static thread_local blobdata blob;
+    get_transaction_prefix_hashing_blob(tx, blob);
+    crypto::cn_fast_hash(blob.data(), blob.size(), h);
   }
   //---------------------------------------------------------------
   crypto::hash get_transaction_prefix_hash(const transaction_prefix& tx)
@@ -34,9 +41,7 @@ namespace cryptonote
   //---------------------------------------------------------------
   bool parse_and_validate_tx_from_blob(const blobdata& tx_blob, transaction& tx)
   {
-    std::stringstream ss;
-    ss << tx_blob;
-    binary_archive<false> ba(ss);
+    binary_archive<false> ba{epee::strspan<uint8_t>(tx_blob)};
     bool r = ::serialization::serialize(ba, tx);
     CHECK_AND_ASSERT_MES(r, false, "Failed to parse transaction from blob");
     return true;
@@ -44,9 +49,7 @@ namespace cryptonote
   //---------------------------------------------------------------
   bool parse_and_validate_tx_from_blob(const blobdata& tx_blob, transaction& tx, crypto::hash& tx_hash, crypto::hash& tx_prefix_hash)
   {
-    std::stringstream ss;
-    ss << tx_blob;
-    binary_archive<false> ba(ss);
+    binary_archive<false> ba{epee::strspan<uint8_t>(tx_blob)};
     bool r = ::serialization::serialize(ba, tx);
     CHECK_AND_ASSERT_MES(r, false, "Failed to parse transaction from blob");
     //TODO: validate tx
@@ -56,6 +59,99 @@ namespace cryptonote
     return true;
   }
   //---------------------------------------------------------------
+  bool tx_extra_reader::measure_field(uint8_t tag, size_t& size) const
+  {
+    const uint8_t* value = m_pos + 1;
+    const size_t left = m_end - value;
+    size_t element_size = 1;
+    switch (tag)
+    {
+      case TX_EXTRA_TAG_PADDING:
+        // padding runs to the end of the extra
+        if (1 + left > TX_EXTRA_PADDING_MAX_COUNT || std::find_if(value, m_end, [](uint8_t b) { return b != 0; }) != m_end)
+          return false;
+        size = left;
+        return true;
+      case TX_EXTRA_TAG_PUBKEY:
+      case TX_EXTRA_TAG_SERVICE_NODE_PUBKEY:
+      case TX_EXTRA_TAG_SERVICE_NODE_WINNER:
+        size = sizeof(crypto::public_key);
+        return size <= left;
+      case TX_EXTRA_TAG_TX_SECRET_KEY:
+        size = sizeof(crypto::secret_key);
+        return size <= left;
+      case TX_EXTRA_TAG_SERVICE_NODE_CONTRIBUTOR:
+        size = 2 * sizeof(crypto::public_key);
+        return size <= left;
+      case TX_EXTRA_TAG_TX_KEY_IMAGE_UNLOCK:
+        size = sizeof(crypto::key_image) + sizeof(crypto::signature) + sizeof(uint32_t);
+        return size <= left;
+      case TX_EXTRA_TAG_ADDITIONAL_PUBKEYS:
+        element_size = sizeof(crypto::public_key);
+        break;
+      case TX_EXTRA_TAG_TX_KEY_IMAGE_PROOFS:
+        element_size = sizeof(tx_extra_tx_key_image_proofs::proof);
+        break;
+      case TX_EXTRA_NONCE:
+      case TX_EXTRA_MERGE_MINING_TAG:
+      case TX_EXTRA_MYSTERIOUS_MINERGATE_TAG:
+      case TX_EXTRA_TAG_OFFSHORE:
+      case TX_EXTRA_TAG_MEMO:
+        break;
+      default:
+      {
+        // the service node fields are rare, they are measured by deserializing them
+        binary_archive<false> ar(m_pos, m_end - m_pos);
+        tx_extra_field field;
+        if (!::do_serialize(ar, field) || !ar.stream().good())
+          return false;
+        size = left - ar.remaining_bytes();
+        return true;
+      }
+    }
+
+    // varint count of elements, then the elements
+    binary_archive<false> ar(value, left);
+    size_t count = 0;
+    ar.serialize_varint(count);
+    if (!ar.stream().good() || (tag == TX_EXTRA_NONCE && count > TX_EXTRA_NONCE_MAX_COUNT))
+      return false;
+    const size_t header = left - ar.remaining_bytes();
+    if (count > (left - header) / element_size)
+      return false;
+    size = header + count * element_size;
+    return true;
+  }
+  //---------------------------------------------------------------
+  bool tx_extra_reader::next(tx_extra_raw_field& field)
+  {
+    if (m_error || m_pos == m_end)
+      return false;
+
+    size_t size = 0;
+    if (!measure_field(*m_pos, size))
+    {
+      m_error = true;
+      return false;
+    }
+    field.tag = *m_pos;
+    field.offset = m_pos - m_begin;
+    field.value = epee::span<const uint8_t>(m_pos + 1, size);
+    m_pos += 1 + size;
+    return true;
+  }
+  //---------------------------------------------------------------
+  bool find_tx_extra_field(const std::vector<uint8_t>& tx_extra, uint8_t tag, tx_extra_raw_field& field)
+  {
+    tx_extra_reader reader(tx_extra);
+    while (reader.next(field))
+    {
+      if (field.tag == tag)
+        return true;
+    }
+    return false;
+  }
+  //---------------------------------------------------------------
   bool parse_tx_extra(const std::vector<uint8_t>& tx_extra, std::vector<tx_extra_field>& tx_extra_fields)
   {
     tx_extra_fields.clear();
@@ -63,9 +159,7 @@ namespace cryptonote
     if(tx_extra.empty())
       return true;
 
-    std::string extra_str(reinterpret_cast<const char*>(tx_extra.data()), tx_extra.size());
-    std::istringstream iss(extra_str);
-    binary_archive<false> ar(iss);
+    binary_archive<false> ar(tx_extra.data(), tx_extra.size());
 
     bool eof = false;
     while (!eof)
@@ -75,9 +169,9 @@ namespace cryptonote
       CHECK_AND_NO_ASSERT_MES(r, false, "failed to deserialize extra field. extra = " << string_tools::buff_to_hex_nodelimer(std::string(reinterpret_cast<const char*>(tx_extra.data()), tx_extra.size())));
       tx_extra_fields.push_back(field);
 
-      std::ios_base::iostate state = iss.rdstate();
-      eof = (EOF == iss.peek());
-      iss.clear(state);
+      std::ios_base::iostate state = ar.stream().rdstate();
+      eof = (EOF == ar.stream().peek());
+      ar.stream().clear(state);
     }
     CHECK_AND_NO_ASSERT_MES(::serialization::check_stream_state(ar), false, "failed to deserialize extra field. extra = " << string_tools::buff_to_hex_nodelimer(std::string(reinterpret_cast<const char*>(tx_extra.data()), tx_extra.size())));
 
@@ -86,14 +180,13 @@ namespace cryptonote
   //---------------------------------------------------------------
   crypto::public_key get_tx_pub_key_from_extra(const std::vector<uint8_t>& tx_extra)
   {
-    std::vector<tx_extra_field> tx_extra_fields;
-    parse_tx_extra(tx_extra, tx_extra_fields);
-
-    tx_extra_pub_key pub_key_field;
-    if(!find_tx_extra_field_by_type(tx_extra_fields, pub_key_field))
+    tx_extra_raw_field field;
+    if(!find_tx_extra_field(tx_extra, TX_EXTRA_TAG_PUBKEY, field))
       return null_pkey;
 
-    return pub_key_field.pub_key;
+    crypto::public_key pub_key;
+    memcpy(&pub_key, field.value.data(), sizeof(pub_key));
+    return pub_key;
   }
   //---------------------------------------------------------------
   crypto::public_key get_tx_pub_key_from_extra(const transaction& tx)
@@ -138,11 +231,18 @@ namespace cryptonote
   //---------------------------------------------------------------
   bool get_mm_tag_from_extra(const std::vector<uint8_t>& tx_extra, tx_extra_merge_mining_tag& mm_tag)
   {
-    std::vector<tx_extra_field> tx_extra_fields;
-    if (!parse_tx_extra(tx_extra, tx_extra_fields))
+    tx_extra_raw_field field;
+    if (!find_tx_extra_field(tx_extra, TX_EXTRA_MERGE_MINING_TAG, field))
       return false;
 
-    return find_tx_extra_field_by_type(tx_extra_fields, mm_tag);
+    // the tag is stored as a string holding the varint depth and the merkle root
+    binary_archive<false> ar(field.value);
+    size_t size = 0;
+    ar.serialize_varint(size);
+    if (!ar.stream().good() || size != ar.remaining_bytes())
+      return false;
+    tx_extra_merge_mining_tag::serialize_helper helper(mm_tag);
+    return ::serialization::serialize(ar, helper);
   }
   //---------------------------------------------------------------
   void set_payment_id_to_tx_extra_nonce(blobdata& extra_nonce, const crypto::hash& payment_id)
@@ -184,60 +284,37 @@ namespace cryptonote
     return h;
   }
   //---------------------------------------------------------------
-  crypto::hash get_transaction_hash(const transaction& t)
+  static void finalize_hash(keccak_ctx& sponge, crypto::hash& h)
   {
-    crypto::hash h = null_hash;
-    size_t blob_size = 0;
-    get_object_hash(t, h, blob_size);
-    return h;
+    uint8_t state[sizeof(state_t)];
+    keccak_finalize(&sponge, state);
+    memcpy(&h, state, sizeof(h));
   }
   //---------------------------------------------------------------
-  bool get_transaction_hash(const transaction& t, crypto::hash& res)
-  {
-    size_t blob_size = 0;
-    return get_object_hash(t, res, blob_size);
-  }
-
-  //---------------------------------------------------------------
-  bool get_transaction_hash(const transaction& t, crypto::hash& res, size_t* blob_size)
+  static bool get_transaction_rct_hashes(const transaction& t, crypto::hash& base_hash, crypto::hash& prunable_hash, size_t* rct_size = nullptr)
   {
-    // v1 transactions hash the entire blob
-    if (t.version == 1 && t.blob_type != BLOB_TYPE_CRYPTONOTE2 && t.blob_type != BLOB_TYPE_CRYPTONOTE3)
-    {
-      size_t ignored_blob_size, &blob_size_ref = blob_size ? *blob_size : ignored_blob_size;
-      return get_object_hash(t, res, blob_size_ref);
-    }
-
-    // v2 transactions hash different parts together, than hash the set of those hashes
-    crypto::hash hashes[3];
-
-    // prefix
-    get_transaction_prefix_hash(t, hashes[0]);
-
     transaction &tt = const_cast<transaction&>(t);
+    keccak_ctx sponge;
+    keccak_init(&sponge);
+    binary_hashing_archive<true> ba(sponge);
+    const size_t inputs  = t.blob_type == BLOB_TYPE_CRYPTONOTE_SALVIUM ? t.vin_salvium.size()  : (t.blob_type == BLOB_TYPE_CRYPTONOTE_ZEPHYR ? t.vin_zephyr.size() : t.vin.size());
+    const size_t outputs = t.blob_type == BLOB_TYPE_CRYPTONOTE_SALVIUM ? t.vout_salvium.size() : (t.blob_type == BLOB_TYPE_CRYPTONOTE_ZEPHYR ? t.vout_zephyr.size() : (t.blob_type != BLOB_TYPE_CRYPTONOTE_XHV ? t.vout.size() : t.vout_xhv.size()));
 
     // base rct
     {
-      std::stringstream ss;
-      binary_archive<true> ba(ss);
-      const size_t inputs  = t.blob_type == BLOB_TYPE_CRYPTONOTE_SALVIUM ? t.vin_salvium.size()  : (t.blob_type == BLOB_TYPE_CRYPTONOTE_ZEPHYR ? t.vin_zephyr.size() : t.vin.size());
-      const size_t outputs = t.blob_type == BLOB_TYPE_CRYPTONOTE_SALVIUM ? t.vout_salvium.size() : (t.blob_type == BLOB_TYPE_CRYPTONOTE_ZEPHYR ? t.vout_zephyr.size() : (t.blob_type != BLOB_TYPE_CRYPTONOTE_XHV ? t.vout.size() : t.vout_xhv.size()));
       bool r = tt.rct_signatures.serialize_rctsig_base(ba, inputs, outputs);
       CHECK_AND_ASSERT_MES(r, false, "Failed to serialize rct signatures base");
-      cryptonote::get_blob_hash(ss.str(), hashes[1]);
+      finalize_hash(sponge, base_hash);
     }
 
     // prunable rct
     if (t.rct_signatures.type == rct::RCTTypeNull)
     {
-      hashes[2] = cryptonote::null_hash;
+      prunable_hash = cryptonote::null_hash;
     }
     else
     {
-      std::stringstream ss;
-      binary_archive<true> ba(ss);
-      const size_t inputs  = t.blob_type == BLOB_TYPE_CRYPTONOTE_SALVIUM ? t.vin_salvium.size()  : (t.blob_type == BLOB_TYPE_CRYPTONOTE_ZEPHYR ? t.vin_zephyr.size() : t.vin.size());
-      const size_t outputs = t.blob_type == BLOB_TYPE_CRYPTONOTE_SALVIUM ? t.vout_salvium.size() : (t.blob_type == BLOB_TYPE_CRYPTONOTE_ZEPHYR ? t.vout_zephyr.size() : (t.blob_type != BLOB_TYPE_CRYPTONOTE_XHV ? t.vout.size() : t.vout_xhv.size()));
+      keccak_init(&sponge);
       size_t mixin;
       if (t.blob_type == BLOB_TYPE_CRYPTONOTE_SALVIUM) {
         mixin = t.vin_salvium.empty() ? 0 : t.vin_salvium[0].type() == typeid(txin_salvium_key) ? boost::get<txin_salvium_key>(t.vin_salvium[0]).key_offsets.size() - 1 : 0;
@@ -256,41 +333,154 @@ namespace cryptonote
       }
       bool r = tt.rct_signatures.p.serialize_rctsig_prunable(ba, t.rct_signatures.type, inputs, outputs, mixin);
       CHECK_AND_ASSERT_MES(r, false, "Failed to serialize rct signatures prunable");
-      cryptonote::get_blob_hash(ss.str(), hashes[2]);
+      finalize_hash(sponge, prunable_hash);
+    }
+
+    // the full tx blob carries the rct part only when the tx has inputs
+    if (rct_size)
+      *rct_size = inputs ? ba.stream().size() : 0;
+    return true;
+  }
+  //---------------------------------------------------------------
+  crypto::hash get_transaction_hash(const transaction& t)
+  {
+    crypto::hash h = null_hash;
+    size_t blob_size = 0;
+    get_object_hash(t, h, blob_size);
+    return h;
+  }
+  //---------------------------------------------------------------
+  bool get_transaction_hash(const transaction& t, crypto::hash& res)
+  {
+    size_t blob_size = 0;
+    return get_object_hash(t, res, blob_size);
+  }
+
+  //---------------------------------------------------------------
+  bool get_transaction_hash(const transaction& t, crypto::hash& res, size_t* blob_size)
+  {
+    // v1 transactions hash the entire blob
+    if (t.version == 1 && t.blob_type != BLOB_TYPE_CRYPTONOTE2 && t.blob_type != BLOB_TYPE_CRYPTONOTE3)
+    {
+      size_t ignored_blob_size, &blob_size_ref = blob_size ? *blob_size : ignored_blob_size;
+      return get_object_hash(t, res, blob_size_ref);
     }
 
+    // v2 transactions hash different parts together, than hash the set of those hashes
+    crypto::hash hashes[3];
+
+    // prefix, hashed and measured straight from the object
+    keccak_ctx sponge;
+    keccak_init(&sponge);
+    if (t.blob_type == BLOB_TYPE_CRYPTONOTE_RYO)
+      keccak_absorb(&sponge, reinterpret_cast<const uint8_t*>("ryo-currency"), 12);
+    binary_hashing_archive<true> ba(sponge);
+    bool r = ::serialization::serialize(ba, const_cast<transaction_prefix&>(static_cast<const transaction_prefix&>(t)));
+    CHECK_AND_ASSERT_MES(r, false, "Failed to serialize transaction prefix");
+    finalize_hash(sponge, hashes[0]);
+
+    size_t rct_size = 0;
+    if (!get_transaction_rct_hashes(t, hashes[1], hashes[2], &rct_size))
+      return false;
+
     // the tx hash is the hash of the 3 hashes
-    res = cn_fast_hash(hashes, sizeof(hashes));
+    res = cn_fast_hash_96(hashes);
 
-    // we still need the size
     if (blob_size)
-      *blob_size = get_object_blobsize(t);
+      *blob_size = ba.stream().size() + rct_size;
 
     return true;
   }
   //---------------------------------------------------------------
+  bool get_transaction_hash_midstate(const transaction& t, size_t extra_nonce_pos, tx_hash_midstate& midstate)
+  {
+    CHECK_AND_ASSERT_MES(extra_nonce_pos < t.extra.size(), false, "extra nonce position is out of tx extra");
+
+    midstate.rct = !(t.version == 1 && t.blob_type != BLOB_TYPE_CRYPTONOTE2 && t.blob_type != BLOB_TYPE_CRYPTONOTE3);
+    if (midstate.rct)
+    {
+      get_transaction_prefix_hashing_blob(t, midstate.data);
+      if (!get_transaction_rct_hashes(t, midstate.rct_hashes[0], midstate.rct_hashes[1]))
+        return false;
+    }
+    else if (!t_serializable_object_to_blob(t, midstate.data))
+    {
+      return false;
+    }
+
+    // extra starts where the serializer tags it, past its size varint; whatever the blob holds
+    // before the serialized object (the ryo hashing prefix) is its length beyond the measured size
+    binary_field_offsets fields{"extra"};
+    binary_size_archive<true> ba(&fields);
+    const bool r = midstate.rct ? ::serialization::serialize(ba, const_cast<transaction_prefix&>(static_cast<const transaction_prefix&>(t)))
+                                : ::serialization::serialize(ba, const_cast<transaction&>(t));
+    CHECK_AND_ASSERT_MES(r && fields.find("extra") != binary_field_offsets::npos && ba.size() <= midstate.data.size(), false, "Failed to locate tx extra in tx blob");
+    binary_size_archive<true> extra_size_ba;
+    size_t extra_size = t.extra.size();
+    extra_size_ba.serialize_varint(extra_size);
+    const size_t extra_offset = midstate.data.size() - ba.size() + fields.find("extra") + extra_size_ba.size();
+    CHECK_AND_ASSERT_MES(extra_offset + extra_size <= midstate.data.size() && !memcmp(&midstate.data[extra_offset], t.extra.data(), extra_size), false, "tx extra is not at its serialized offset");
+    midstate.extra_nonce_offset = extra_offset + extra_nonce_pos;
+    midstate.absorbed = midstate.extra_nonce_offset - midstate.extra_nonce_offset % KECCAK_BLOCKLEN;
+
+    keccak_init(&midstate.state);
+    keccak_absorb(&midstate.state, reinterpret_cast<const uint8_t*>(midstate.data.data()), midstate.absorbed);
+    return true;
+  }
+  //---------------------------------------------------------------
+  bool get_transaction_hash(const tx_hash_midstate& midstate, const void* extra_nonce, size_t extra_nonce_size, crypto::hash& res)
+  {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(midstate.data.data());
+    const size_t tail_offset = midstate.extra_nonce_offset + extra_nonce_size;
+    CHECK_AND_ASSERT_MES(tail_offset <= midstate.data.size(), false, "extra nonce is out of tx blob");
+
+    keccak_ctx ctx = midstate.state;
+    uint8_t state[sizeof(state_t)];
+    keccak_absorb(&ctx, data + midstate.absorbed, midstate.extra_nonce_offset - midstate.absorbed);
+    keccak_absorb(&ctx, reinterpret_cast<const uint8_t*>(extra_nonce), extra_nonce_size);
+    keccak_absorb(&ctx, data + tail_offset, midstate.data.size() - tail_offset);
+    keccak_finalize(&ctx, state);
+
+    if (!midstate.rct)
+    {
+      memcpy(&res, state, sizeof(res));
+      return true;
+    }
+
+    crypto::hash hashes[3];
+    memcpy(&hashes[0], state, sizeof(hashes[0]));
+    hashes[1] = midstate.rct_hashes[0];
+    hashes[2] = midstate.rct_hashes[1];
+    res = cn_fast_hash_96(hashes);
+    return true;
+  }
+  //---------------------------------------------------------------
   bool get_transaction_hash(const transaction& t, crypto::hash& res, size_t& blob_size)
   {
     return get_transaction_hash(t, res, &blob_size);
   }
   //---------------------------------------------------------------
   bool get_block_hashing_blob(const block& b, blobdata& blob)
+  {
+    return get_block_hashing_blob(b, get_tx_tree_hash(b), blob);
+  }
+  //---------------------------------------------------------------
+  bool get_block_hashing_blob(const block& b, const crypto::hash& tree_root_hash, blobdata& blob)
   {
     if (b.blob_type == BLOB_TYPE_CRYPTONOTE_XTNC || b.blob_type == BLOB_TYPE_CRYPTONOTE_CUCKOO || b.blob_type == BLOB_TYPE_CRYPTONOTE_TUBE || b.blob_type == BLOB_TYPE_CRYPTONOTE_XTA) {
-      blob = t_serializable_object_to_blob(b.major_version);
+      t_serializable_object_to_blob(b.major_version, blob);
       blob.append(reinterpret_cast<const char*>(&b.minor_version), sizeof(b.minor_version));
       blob.append(reinterpret_cast<const char*>(&b.timestamp), sizeof(b.timestamp));
       blob.append(reinterpret_cast<const char*>(&b.prev_id), sizeof(b.prev_id));
     }
     else {
-      blob = t_serializable_object_to_blob(static_cast<const block_header&>(b));
+      t_serializable_object_to_blob(static_cast<const block_header&>(b), blob);
     }
-    crypto::hash tree_root_hash = get_tx_tree_hash(b);
     blob.append(reinterpret_cast<const char*>(&tree_root_hash), sizeof(tree_root_hash));
     if (b.blob_type == BLOB_TYPE_CRYPTONOTE_SALVIUM) {
-      blob.append(tools::get_varint_data(b.tx_hashes.size() + (b.major_version >= HF_VERSION_ENABLE_N_OUTS ? 2 : 1)));
+      tools::write_varint(std::back_inserter(blob), b.tx_hashes.size() + (b.major_version >= HF_VERSION_ENABLE_N_OUTS ? 2 : 1));
     } else {
-      blob.append(tools::get_varint_data(b.tx_hashes.size()+1));
+      tools::write_varint(std::back_inserter(blob), b.tx_hashes.size()+1);
     }
     if (b.blob_type == BLOB_TYPE_CRYPTONOTE3) {
       blob.append(reinterpret_cast<const char*>(&b.uncle), sizeof(b.uncle));
@@ -373,9 +563,7 @@ namespace cryptonote
   //---------------------------------------------------------------
   bool parse_and_validate_block_from_blob(const blobdata& b_blob, block& b)
   {
-    std::stringstream ss;
-    ss << b_blob;
-    binary_archive<false> ba(ss);
+    binary_archive<false> ba{epee::strspan<uint8_t>(b_blob)};
     bool r = ::serialization::serialize(ba, b);
     CHECK_AND_ASSERT_MES(r, false, "Failed to parse block from blob 1");
     return true;
@@ -391,6 +579,43 @@ namespace cryptonote
     return t_serializable_object_to_blob(b, b_blob);
   }
   //---------------------------------------------------------------
+  bool get_block_layout(const block& b, block_layout& layout)
+  {
+    // parent blocks of merge mined blocks come first, only their fields are tagged b.*
+    binary_field_offsets fields{"nonce", "cycle", "cycle40", "cycle48", "miner_tx", "tx_hashes"};
+    binary_size_archive<true> ba(&fields);
+    if (!::serialization::serialize(ba, const_cast<block&>(b)))
+      return false;
+
+    binary_field_offsets tx_fields{"extra"};
+    binary_size_archive<true> tx_ba(&tx_fields);
+    if (!::serialization::serialize(tx_ba, const_cast<transaction&>(b.miner_tx)))
+      return false;
+    binary_size_archive<true> extra_size_ba;
+    size_t extra_size = b.miner_tx.extra.size();
+    extra_size_ba.serialize_varint(extra_size);
+
+    layout.nonce = fields.find("nonce");
+    layout.nonce_size = b.blob_type == BLOB_TYPE_AEON ? sizeof(uint64_t) : sizeof(uint32_t);
+    layout.cycle = block_layout::npos;
+    layout.cycle_size = 0;
+    if (b.blob_type == BLOB_TYPE_CRYPTONOTE_XTNC || b.blob_type == BLOB_TYPE_CRYPTONOTE_CUCKOO) {
+      layout.cycle = fields.find("cycle");
+      layout.cycle_size = sizeof(b.cycle);
+    } else if (b.blob_type == BLOB_TYPE_CRYPTONOTE_TUBE) {
+      layout.cycle = fields.find("cycle40");
+      layout.cycle_size = sizeof(b.cycle40);
+    } else if (b.blob_type == BLOB_TYPE_CRYPTONOTE_XTA) {
+      layout.cycle = fields.find("cycle48");
+      layout.cycle_size = sizeof(b.cycle48);
+    }
+    layout.miner_tx_extra = fields.find("miner_tx") + tx_fields.find("extra") + extra_size_ba.size();
+    layout.miner_tx_extra_size = extra_size;
+    layout.tx_hashes = fields.find("tx_hashes");
+    layout.size = ba.size();
+    return true;
+  }
+  //---------------------------------------------------------------
   blobdata tx_to_blob(const transaction& tx)
   {
     return t_serializable_object_to_blob(tx);
@@ -423,7 +648,7 @@ namespace cryptonote
       txs_ids.push_back(h);
       h = null_hash;
       bl_sz = 0;
-      get_transaction_hash(b.protocol_tx, h, bl_sz);
+      get_transaction_hash(*b.protocol_tx, h, bl_sz);
     }
     txs_ids.push_back(h);
     BOOST_FOREACH(auto& th, b.tx_hashes)
@@ -431,4 +656,35 @@ namespace cryptonote
     return get_tx_tree_hash(txs_ids);
   }
   //---------------------------------------------------------------
+  // Merkle branch of the miner tx leaf: everything but the miner tx is fixed for a template,
+  // so the root for a new extra nonce is an O(log n) walk up from the new miner tx hash
+  void get_tx_tree_branch(const block& b, std::vector<crypto::hash>& branch)
+  {
+    std::vector<crypto::hash> txs_ids;
+    txs_ids.reserve(b.tx_hashes.size() + 2);
+    txs_ids.push_back(null_hash); // miner tx leaf is not part of its own branch
+    if (b.blob_type == BLOB_TYPE_CRYPTONOTE_SALVIUM) {
+      crypto::hash h = null_hash;
+      get_transaction_hash(*b.protocol_tx, h, nullptr);
+      txs_ids.push_back(h);
+    }
+    txs_ids.insert(txs_ids.end(), b.tx_hashes.begin(), b.tx_hashes.end());
+    branch.resize(crypto::tree_depth(txs_ids.size()));
+    crypto::tree_branch(txs_ids.data(), txs_ids.size(), branch.data());
+  }
+  //---------------------------------------------------------------
+  crypto::hash get_tx_tree_hash(const block& b, const std::vector<crypto::hash>& branch)
+  {
+    crypto::hash h = null_hash;
+    get_transaction_hash(b.miner_tx, h, nullptr);
+    return get_tx_tree_hash(h, branch);
+  }
+  //---------------------------------------------------------------
+  crypto::hash get_tx_tree_hash(const crypto::hash& miner_tx_hash, const std::vector<crypto::hash>& branch)
+  {
+    crypto::hash root = null_hash;
+    crypto::tree_hash_from_branch(branch.data(), branch.size(), miner_tx_hash, 0, root);
+    return root;
+  }
+  //---------------------------------------------------------------
 }
@@ -10,7 +10,11 @@
 #include "include_base_utils.h"
 #include "crypto/crypto.h"
 #include "crypto/hash.h"
+#include "serialization/binary_size_archive.h"
 
+extern "C" {
+#include "crypto/keccak.h"
+}
 
 namespace cryptonote
 {
@@ -54,6 +58,36 @@ namespace cryptonote
     return true;
   }
 
+  // One field of a tx extra as stored: its tag, the offset of the tag and the bytes after it
+  struct tx_extra_raw_field
+  {
+    uint8_t tag;
+    size_t offset;
+    epee::span<const uint8_t> value;
+  };
+
+  // Walks the fields of a tx extra in place. Fields are measured rather than deserialized, so
+  // looking up one tag costs a few byte reads per field in front of it.
+  class tx_extra_reader
+  {
+  public:
+    explicit tx_extra_reader(const std::vector<uint8_t>& tx_extra) : m_begin(tx_extra.data()), m_pos(tx_extra.data()), m_end(tx_extra.data() + tx_extra.size()), m_error(false) {}
+
+    // false at the end of the extra and on a malformed field, error() tells them apart
+    bool next(tx_extra_raw_field& field);
+    bool error() const { return m_error; }
+
+  private:
+    bool measure_field(uint8_t tag, size_t& size) const;
+
+    const uint8_t* m_begin;
+    const uint8_t* m_pos;
+    const uint8_t* m_end;
+    bool m_error;
+  };
+
+  // first field with the tag in front of any malformed one
+  bool find_tx_extra_field(const std::vector<uint8_t>& tx_extra, uint8_t tag, tx_extra_raw_field& field);
   bool parse_tx_extra(const std::vector<uint8_t>& tx_extra, std::vector<tx_extra_field>& tx_extra_fields);
   crypto::public_key get_tx_pub_key_from_extra(const std::vector<uint8_t>& tx_extra);
   crypto::public_key get_tx_pub_key_from_extra(const transaction& tx);
@@ -71,7 +105,22 @@ namespace cryptonote
   bool get_transaction_hash(const transaction& t, crypto::hash& res);
   bool get_transaction_hash(const transaction& t, crypto::hash& res, size_t& blob_size);
   bool get_transaction_hash(const transaction& t, crypto::hash& res, size_t* blob_size);
+
+  // Keccak midstate of a tx hashing stream up to a reserved extra nonce: the bytes before it
+  // never change within a block template, so a new extra nonce only re-absorbs the tail
+  struct tx_hash_midstate
+  {
+    blobdata data;              // prefix blob for v2 txes, whole tx blob for v1 txes
+    size_t extra_nonce_offset;  // position of the reserved extra nonce inside data
+    size_t absorbed;            // leading data bytes already absorbed into state
+    keccak_ctx state;
+    bool rct;                   // v2 txes hash the prefix hash together with both rct hashes
+    crypto::hash rct_hashes[2];
+  };
+  bool get_transaction_hash_midstate(const transaction& t, size_t extra_nonce_pos, tx_hash_midstate& midstate);
+  bool get_transaction_hash(const tx_hash_midstate& midstate, const void* extra_nonce, size_t extra_nonce_size, crypto::hash& res);
   bool get_block_hashing_blob(const block& b, blobdata& blob);
+  bool get_block_hashing_blob(const block& b, const crypto::hash& tree_root_hash, blobdata& blob);
   bool get_bytecoin_block_hashing_blob(const block& b, blobdata& blob);
   bool get_block_hash(const block& b, crypto::hash& res);
   crypto::hash get_block_hash(const block& b);
@@ -87,11 +136,9 @@ namespace cryptonote
   template<class t_object>
   bool t_serializable_object_to_blob(const t_object& to, blobdata& b_blob)
   {
-    std::stringstream ss;
-    binary_archive<true> ba(ss);
-    bool r = ::serialization::serialize(ba, const_cast<t_object&>(to));
-    b_blob = ss.str();
-    return r;
+    b_blob.clear();
+    binary_archive<true> ba(b_blob);
+    return ::serialization::serialize(ba, const_cast<t_object&>(to));
   }
   //---------------------------------------------------------------
   template<class t_object>
@@ -103,28 +150,31 @@ namespace cryptonote
   }
   //---------------------------------------------------------------
   template<class t_object>
-  bool get_object_hash(const t_object& o, crypto::hash& res)
-  {
-    get_blob_hash(t_serializable_object_to_blob(o), res);
-    return true;
-  }
-  //---------------------------------------------------------------
-  template<class t_object>
   size_t get_object_blobsize(const t_object& o)
   {
-    blobdata b = t_serializable_object_to_blob(o);
-    return b.size();
+    binary_size_archive<true> ba;
+    ::serialization::serialize(ba, const_cast<t_object&>(o));
+    return ba.size();
   }
   //---------------------------------------------------------------
   template<class t_object>
   bool get_object_hash(const t_object& o, crypto::hash& res, size_t& blob_size)
   {
-    blobdata bl = t_serializable_object_to_blob(o);
+    // per thread serialization buffer, it stops allocating once grown to the largest object
+    static thread_local blobdata bl;
+    t_serializable_object_to_blob(o, bl);
     blob_size = bl.size();
     get_blob_hash(bl, res);
     return true;
   }
   //---------------------------------------------------------------
+  template<class t_object>
+  bool get_object_hash(const t_object& o, crypto::hash& res)
+  {
+    size_t blob_size;
+    return get_object_hash(o, res, blob_size);
+  }
+  //---------------------------------------------------------------
   // 62387455827 -> 455827 + 7000000 + 80000000 + 300000000 + 2000000000 + 60000000000, where 455827 <= dust_threshold
   template<typename chunk_handler_t, typename dust_handler_t>
   void decompose_amount_into_digits(uint64_t amount, uint64_t dust_threshold, const chunk_handler_t& chunk_handler, const dust_handler_t& dust_handler)
@@ -169,11 +219,31 @@ namespace cryptonote
   //---------------------------------------------------------------
   blobdata block_to_blob(const block& b);
   bool block_to_blob(const block& b, blobdata& b_blob);
+  //---------------------------------------------------------------
+  // byte offsets in the blob of a block of the fields that change between submissions of one
+  // template, block_layout::npos for fields its blob type does not have
+  struct block_layout
+  {
+    static constexpr size_t npos = binary_field_offsets::npos;
+
+    size_t nonce;
+    size_t nonce_size;
+    size_t cycle;
+    size_t cycle_size;
+    size_t miner_tx_extra;  // first byte of the miner tx extra data, after its length
+    size_t miner_tx_extra_size;
+    size_t tx_hashes;       // tx hashes count followed by the hashes
+    size_t size;
+  };
+  bool get_block_layout(const block& b, block_layout& layout);
   blobdata tx_to_blob(const transaction& b);
   bool tx_to_blob(const transaction& b, blobdata& b_blob);
   void get_tx_tree_hash(const std::vector<crypto::hash>& tx_hashes, crypto::hash& h);
   crypto::hash get_tx_tree_hash(const std::vector<crypto::hash>& tx_hashes);
   crypto::hash get_tx_tree_hash(const block& b);
+  void get_tx_tree_branch(const block& b, std::vector<crypto::hash>& branch);
+  crypto::hash get_tx_tree_hash(const block& b, const std::vector<crypto::hash>& branch);
+  crypto::hash get_tx_tree_hash(const crypto::hash& miner_tx_hash, const std::vector<crypto::hash>& branch);
 
 #define CHECKED_GET_SPECIFIC_VARIANT(variant_var, specific_type, variable_name, fail_return_val) \
   CHECK_AND_ASSERT_MES(variant_var.type() == typeid(specific_type), fail_return_val, "wrong variant type: " << variant_var.type().name() << ", expected " << typeid(specific_type).name()); \
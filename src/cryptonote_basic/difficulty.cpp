@@ -0,0 +1,232 @@
+// Copyright (c) 2012-2013 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "common/int-util.h"
+#include "cryptonote_config.h"
+#include "crypto/hash.h"
+#include "difficulty.h"
+
+namespace cryptonote {
+
+  using std::size_t;
+  using std::uint64_t;
+  using std::vector;
+
+  static inline void mul(uint64_t a, uint64_t b, uint64_t &low, uint64_t &high) {
+    low = mul128(a, b, &high);
+  }
+
+  static inline bool cadd(uint64_t a, uint64_t b) {
+    return a + b < a;
+  }
+
+  static inline bool cadc(uint64_t a, uint64_t b, bool c) {
+    return a + b < a || (c && a + b == (uint64_t) -1);
+  }
+
+  // the hash read as a 256 bit little endian number, times difficulty, must fit 256 bits
+  bool check_hash(const crypto::hash &hash, difficulty_type difficulty) {
+    uint64_t low, high, top, cur;
+    // First check the highest word, this will most likely fail for a random hash.
+    mul(swap64le(((const uint64_t *) &hash)[3]), difficulty, top, high);
+    if (high != 0) {
+      return false;
+    }
+    mul(swap64le(((const uint64_t *) &hash)[0]), difficulty, low, cur);
+    mul(swap64le(((const uint64_t *) &hash)[1]), difficulty, low, high);
+    bool carry = cadd(cur, low);
+    cur = high;
+    mul(swap64le(((const uint64_t *) &hash)[2]), difficulty, low, high);
+    carry = cadc(cur, low, carry);
+    carry = cadc(high, top, carry);
+    return !carry;
+  }
+
+  // the sorted timestamps used once cut outliers are dropped at both ends
+  static void cut_range(size_t length, size_t window, size_t cut, size_t &cut_begin, size_t &cut_end) {
+    if (length <= window - 2 * cut) {
+      cut_begin = 0;
+      cut_end = length;
+    } else {
+      cut_begin = (length - (window - 2 * cut) + 1) / 2;
+      cut_end = cut_begin + (window - 2 * cut);
+    }
+  }
+
+  static difficulty_type cut_difficulty(uint64_t time_span, difficulty_type total_work, size_t target_seconds) {
+    if (time_span == 0) {
+      time_span = 1;
+    }
+    uint64_t low, high;
+    mul(total_work, target_seconds, low, high);
+    if (high != 0 || low + time_span - 1 < low) {
+      return 0;
+    }
+    return (low + time_span - 1) / time_span;
+  }
+
+  difficulty_type next_difficulty(vector<uint64_t> timestamps, vector<difficulty_type> cumulative_difficulties) {
+    return next_difficulty(std::move(timestamps), std::move(cumulative_difficulties), DIFFICULTY_TARGET);
+  }
+
+  difficulty_type next_difficulty(vector<uint64_t> timestamps, vector<difficulty_type> cumulative_difficulties, size_t target_seconds) {
+    return next_difficulty(std::move(timestamps), std::move(cumulative_difficulties), target_seconds, DIFFICULTY_WINDOW, DIFFICULTY_CUT);
+  }
+
+  difficulty_type next_difficulty(vector<uint64_t> timestamps, vector<difficulty_type> cumulative_difficulties, size_t target_seconds, size_t window, size_t cut) {
+    assert(2 * cut <= window - 2);
+    if (timestamps.size() > window) {
+      timestamps.resize(window);
+      cumulative_difficulties.resize(window);
+    }
+    size_t length = timestamps.size();
+    assert(length == cumulative_difficulties.size());
+    if (length <= 1) {
+      return 1;
+    }
+    size_t cut_begin, cut_end;
+    cut_range(length, window, cut, cut_begin, cut_end);
+    // only the two timestamps bounding the cut range are needed, not a full sort
+    std::nth_element(timestamps.begin(), timestamps.begin() + cut_begin, timestamps.end());
+    std::nth_element(timestamps.begin() + cut_begin + 1, timestamps.begin() + cut_end - 1, timestamps.end());
+    return cut_difficulty(timestamps[cut_end - 1] - timestamps[cut_begin], cumulative_difficulties[cut_end - 1] - cumulative_difficulties[cut_begin], target_seconds);
+  }
+
+  // LWMA-1 starts one target before the first block and forces each timestamp past the one
+  // before it, so out of order timestamps count as one second
+  static inline uint64_t lwma_adjusted(uint64_t timestamp, uint64_t previous) {
+    return timestamp > previous ? timestamp : previous + 1;
+  }
+
+  static inline uint64_t lwma_solve_time(uint64_t adjusted, uint64_t previous, size_t target_seconds) {
+    return std::min<uint64_t>(6 * target_seconds, adjusted - previous);
+  }
+
+  // n solve times of weighted sum L, computed as the reference code does it so the result
+  // is the one of the daemons: in 64 bits, dividing first for high difficulties, digits past
+  // the third significant one rounded off
+  static difficulty_type lwma_difficulty(uint64_t weighted_solve_time, difficulty_type total_work, uint64_t n, uint64_t target_seconds) {
+    weighted_solve_time = std::max(weighted_solve_time, n * n * target_seconds / 20);
+    const difficulty_type average = total_work / n;
+    difficulty_type next;
+    if (average > 2000000 * n * n * target_seconds) {
+      next = average / (200 * weighted_solve_time) * (n * (n + 1) * target_seconds * 99);
+    } else {
+      next = average * n * (n + 1) * target_seconds * 99 / (200 * weighted_solve_time);
+    }
+    for (uint64_t unit = 1000000000; unit > 1; unit /= 10) {
+      if (next > unit * 100) {
+        next = (next + unit / 2) / unit * unit;
+        break;
+      }
+    }
+    return next;
+  }
+
+  difficulty_type next_difficulty_lwma(const vector<uint64_t> &timestamps, const vector<difficulty_type> &cumulative_difficulties, size_t target_seconds, size_t window) {
+    assert(timestamps.size() == cumulative_difficulties.size());
+    if (timestamps.size() < window + 1) {
+      return 1;
+    }
+    const size_t first = timestamps.size() - (window + 1), n = window;
+    uint64_t previous = timestamps[first] - target_seconds, weighted_solve_time = 0;
+    for (size_t i = 1; i <= n; ++i) {
+      const uint64_t adjusted = lwma_adjusted(timestamps[first + i], previous);
+      weighted_solve_time += i * lwma_solve_time(adjusted, previous, target_seconds);
+      previous = adjusted;
+    }
+    return lwma_difficulty(weighted_solve_time, cumulative_difficulties[first + n] - cumulative_difficulties[first], n, target_seconds);
+  }
+
+  difficulty_window::difficulty_window(difficulty_algorithm algorithm, size_t target_seconds, size_t window, size_t lag, size_t cut)
+    : m_algorithm(algorithm), m_target_seconds(target_seconds), m_window(window), m_lag(lag), m_cut(cut),
+      m_solve_time_sum(0), m_weighted_solve_time(0) {
+    assert(window > 0);
+    if (m_algorithm == DIFFICULTY_ALGORITHM_CRYPTONOTE) {
+      assert(2 * cut <= window - 2);
+      m_sorted_timestamps.reserve(window);
+    }
+  }
+
+  void difficulty_window::add_block(uint64_t timestamp, difficulty_type cumulative_difficulty) {
+    if (m_algorithm == DIFFICULTY_ALGORITHM_LWMA) {
+      if (m_blocks.size() == m_window + 1) {
+        // every solve time moves one weight down, the one of the new first block drops out
+        m_blocks.pop_front();
+        m_weighted_solve_time -= m_solve_time_sum;
+        m_solve_time_sum -= m_blocks.front().solve_time;
+        m_blocks.front().solve_time = 0;
+        lwma_rechain();
+      }
+      block_entry b = {timestamp, cumulative_difficulty, timestamp - m_target_seconds, 0};
+      if (!m_blocks.empty()) {
+        const uint64_t previous = m_blocks.back().adjusted_timestamp;
+        b.adjusted_timestamp = lwma_adjusted(timestamp, previous);
+        b.solve_time = lwma_solve_time(b.adjusted_timestamp, previous, m_target_seconds);
+        m_solve_time_sum += b.solve_time;
+        m_weighted_solve_time += m_blocks.size() * b.solve_time;
+      }
+      m_blocks.push_back(b);
+      return;
+    }
+
+    // the window is the oldest m_window of the last m_window + m_lag blocks
+    const bool full = m_blocks.size() == m_window + m_lag;
+    if (full) {
+      m_sorted_timestamps.erase(std::lower_bound(m_sorted_timestamps.begin(), m_sorted_timestamps.end(), m_blocks.front().timestamp));
+      m_blocks.pop_front();
+    }
+    m_blocks.push_back(block_entry{timestamp, cumulative_difficulty, 0, 0});
+    if (m_blocks.size() <= m_window || full) {
+      const uint64_t entering = m_blocks[std::min(m_blocks.size(), m_window) - 1].timestamp;
+      m_sorted_timestamps.insert(std::upper_bound(m_sorted_timestamps.begin(), m_sorted_timestamps.end(), entering), entering);
+    }
+  }
+
+  // After the first block is dropped the window starts one target before the new first
+  // block. Its adjusted timestamps change only up to where they meet the old chain again.
+  void difficulty_window::lwma_rechain() {
+    block_entry &front = m_blocks.front();
+    front.adjusted_timestamp = front.timestamp - m_target_seconds;
+    for (size_t i = 1; i < m_blocks.size(); ++i) {
+      block_entry &b = m_blocks[i];
+      const uint64_t previous = m_blocks[i - 1].adjusted_timestamp;
+      const uint64_t adjusted = lwma_adjusted(b.timestamp, previous);
+      const uint64_t solve_time = lwma_solve_time(adjusted, previous, m_target_seconds);
+      // unsigned wrap cancels out, the sums stay exact
+      m_solve_time_sum += solve_time - b.solve_time;
+      m_weighted_solve_time += i * (solve_time - b.solve_time);
+      b.solve_time = solve_time;
+      if (adjusted == b.adjusted_timestamp) {
+        break;
+      }
+      b.adjusted_timestamp = adjusted;
+    }
+  }
+
+  difficulty_type difficulty_window::next_difficulty() const {
+    if (m_algorithm == DIFFICULTY_ALGORITHM_LWMA) {
+      if (m_blocks.size() < m_window + 1) {
+        return 1;
+      }
+      return lwma_difficulty(m_weighted_solve_time, m_blocks.back().cumulative_difficulty - m_blocks.front().cumulative_difficulty, m_blocks.size() - 1, m_target_seconds);
+    }
+
+    const size_t length = m_sorted_timestamps.size();
+    if (length <= 1) {
+      return 1;
+    }
+    size_t cut_begin, cut_end;
+    cut_range(length, m_window, m_cut, cut_begin, cut_end);
+    return cut_difficulty(m_sorted_timestamps[cut_end - 1] - m_sorted_timestamps[cut_begin], m_blocks[cut_end - 1].cumulative_difficulty - m_blocks[cut_begin].cumulative_difficulty, m_target_seconds);
+  }
+
+}
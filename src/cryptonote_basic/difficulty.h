@@ -5,6 +5,7 @@
 #pragma once
 
 #include <cstdint>
+#include <deque>
 #include <vector>
 
 #include "crypto/hash.h"
@@ -13,7 +14,52 @@ namespace cryptonote
 {
     typedef std::uint64_t difficulty_type;
 
+    enum difficulty_algorithm {
+        DIFFICULTY_ALGORITHM_CRYPTONOTE = 0, // windowed average with outlying timestamps cut
+        DIFFICULTY_ALGORITHM_LWMA       = 1, // zawy's LWMA-1, solve times weighted by age
+    };
+
     bool check_hash(const crypto::hash &hash, difficulty_type difficulty);
     difficulty_type next_difficulty(std::vector<std::uint64_t> timestamps, std::vector<difficulty_type> cumulative_difficulties);
     difficulty_type next_difficulty(std::vector<std::uint64_t> timestamps, std::vector<difficulty_type> cumulative_difficulties, size_t target_seconds);
+    difficulty_type next_difficulty(std::vector<std::uint64_t> timestamps, std::vector<difficulty_type> cumulative_difficulties, size_t target_seconds, size_t window, size_t cut);
+    // over the last window + 1 blocks, 1 while the chain is shorter as the reference only
+    // defines it over a full window
+    difficulty_type next_difficulty_lwma(const std::vector<std::uint64_t>& timestamps, const std::vector<difficulty_type>& cumulative_difficulties, size_t target_seconds, size_t window);
+
+    // Next difficulty of a chain fed one block at a time, the same as the functions above give
+    // for its last blocks. Adding a block updates the window in place: the cryptonote
+    // timestamps stay sorted so only the block entering and the one leaving move, LWMA keeps
+    // its weighted sums. Cumulative difficulties are only subtracted, so they may wrap.
+    class difficulty_window
+    {
+    public:
+        // lag and cut only apply to DIFFICULTY_ALGORITHM_CRYPTONOTE, which needs window > 2 * cut
+        difficulty_window(difficulty_algorithm algorithm, size_t target_seconds, size_t window, size_t lag = 0, size_t cut = 0);
+
+        void add_block(std::uint64_t timestamp, difficulty_type cumulative_difficulty);
+        difficulty_type next_difficulty() const;
+        size_t size() const { return m_blocks.size(); }
+
+    private:
+        struct block_entry
+        {
+            std::uint64_t timestamp;
+            difficulty_type cumulative_difficulty;
+            std::uint64_t adjusted_timestamp; // LWMA: timestamp forced after the one before
+            std::uint64_t solve_time;         // LWMA: since the block before, 0 for the first
+        };
+
+        void lwma_rechain();
+
+        difficulty_algorithm m_algorithm;
+        size_t m_target_seconds;
+        size_t m_window;
+        size_t m_lag;
+        size_t m_cut;
+        std::deque<block_entry> m_blocks;
+        std::vector<std::uint64_t> m_sorted_timestamps; // cryptonote: of the oldest m_window blocks
+        std::uint64_t m_solve_time_sum;      // LWMA: of the blocks after the first
+        std::uint64_t m_weighted_solve_time; // LWMA: each times its index
+    };
 }
@@ -40,3 +40,12 @@ enum BLOB_TYPE {
   BLOB_TYPE_CRYPTONOTE_XLA    = 14, // XLA
   BLOB_TYPE_CRYPTONOTE_SALVIUM= 15, // Salvium
 };
+
+// classic cryptonote difficulty: the window is the oldest DIFFICULTY_WINDOW of the last
+// DIFFICULTY_BLOCKS_COUNT blocks, less DIFFICULTY_CUT outlying timestamps at each end
+#define DIFFICULTY_TARGET                               120  // seconds
+#define DIFFICULTY_WINDOW                               720  // blocks
+#define DIFFICULTY_LAG                                  15
+#define DIFFICULTY_CUT                                  60   // timestamps to cut after sorting
+#define DIFFICULTY_BLOCKS_COUNT                         (DIFFICULTY_WINDOW + DIFFICULTY_LAG)
+#define DIFFICULTY_WINDOW_LWMA                          60   // solve times LWMA weighs
@@ -5,9 +5,12 @@
 #include <stdint.h>
 #include <string>
 #include <algorithm>
+#include <functional>
 #include "cryptonote_basic/cryptonote_basic.h"
 #include "cryptonote_basic/cryptonote_format_utils.h"
+#include "cryptonote_basic/difficulty.h"
 #include "common/base58.h"
+#include "common/thread_pool.h"
 #include "serialization/binary_utils.h"
 #include <nan.h>
 
@@ -64,24 +67,19 @@ static bool fillExtraMM(cryptonote::block& block1, const cryptonote::block& bloc
     }
 
     std::vector<uint8_t>& extra = block1.miner_tx.extra;
-    size_t pos = 0;
-
-    while (pos < extra.size() && extra[pos] != TX_EXTRA_NONCE) {
-       switch (extra[pos]) {
-           case TX_EXTRA_TAG_PUBKEY: pos += 1 + sizeof(crypto::public_key); break;
-           default: {
-               fprintf(stderr, "Not supported extra tag found: %x\n", extra[pos]);
-               return false;
-           }
-       }
-    }
-
-    if (pos + 1 >= extra.size()) {
+    cryptonote::tx_extra_raw_field nonce_field;
+    if (!cryptonote::find_tx_extra_field(extra, TX_EXTRA_NONCE, nonce_field) || nonce_field.value.empty()) {
         fprintf(stderr, "Can't find TX_EXTRA_NONCE in extra\n");
         return false;
     }
+    // the nonce size is rewritten in place below, it has to stay a one byte varint
+    if (nonce_field.value[0] & 0x80) {
+        fprintf(stderr, "Too big TX_EXTRA_NONCE in extra\n");
+        return false;
+    }
+    const size_t pos = nonce_field.offset;
 
-    const int extra_nonce_size = extra[pos + 1];
+    const int extra_nonce_size = nonce_field.value[0];
     const int new_extra_nonce_size = extra_nonce_size - MM_NONCE_SIZE;
 
     if (new_extra_nonce_size < 0) {
@@ -101,18 +99,18 @@ static bool fillExtraMM(cryptonote::block& block1, const cryptonote::block& bloc
 
 static bool mergeBlocks(const cryptonote::block& block1, cryptonote::block& block2, const std::vector<crypto::hash>& branch2) {
     block2.timestamp = block1.timestamp;
-    block2.parent_block.major_version = block1.major_version;
-    block2.parent_block.minor_version = block1.minor_version;
-    block2.parent_block.prev_id       = block1.prev_id;
-    block2.parent_block.nonce         = block1.nonce;
-    block2.parent_block.miner_tx      = block1.miner_tx;
-    block2.parent_block.number_of_transactions = block1.tx_hashes.size() + 1;
-    block2.parent_block.miner_tx_branch.resize(crypto::tree_depth(block1.tx_hashes.size() + 1));
+    block2.parent_block->major_version = block1.major_version;
+    block2.parent_block->minor_version = block1.minor_version;
+    block2.parent_block->prev_id       = block1.prev_id;
+    block2.parent_block->nonce         = block1.nonce;
+    block2.parent_block->miner_tx      = block1.miner_tx;
+    block2.parent_block->number_of_transactions = block1.tx_hashes.size() + 1;
+    block2.parent_block->miner_tx_branch.resize(crypto::tree_depth(block1.tx_hashes.size() + 1));
     std::vector<crypto::hash> transactionHashes;
     transactionHashes.push_back(cryptonote::get_transaction_hash(block1.miner_tx));
     std::copy(block1.tx_hashes.begin(), block1.tx_hashes.end(), std::back_inserter(transactionHashes));
-    tree_branch(transactionHashes.data(), transactionHashes.size(), block2.parent_block.miner_tx_branch.data());
-    block2.parent_block.blockchain_branch = branch2;
+    tree_branch(transactionHashes.data(), transactionHashes.size(), block2.parent_block->miner_tx_branch.data());
+    block2.parent_block->blockchain_branch = branch2;
     return true;
 }
 
@@ -121,126 +119,311 @@ static bool construct_parent_block(const cryptonote::block& b, cryptonote::block
     parent_block.minor_version = 0;
     parent_block.timestamp = b.timestamp;
     parent_block.prev_id = b.prev_id;
-    parent_block.nonce = b.parent_block.nonce;
+    parent_block.nonce = b.parent_block->nonce;
     parent_block.miner_tx.version = CURRENT_TRANSACTION_VERSION;
     parent_block.miner_tx.unlock_time = 0;
     return fillExtra(parent_block, b);
 }
 
-NAN_METHOD(convert_blob) { // (parentBlockBuffer, cnBlobType)
-    if (info.Length() < 1) return THROW_ERROR_EXCEPTION("You must provide one argument.");
+// Blob methods parse their JS arguments into a job holding copies of all inputs, so the same
+// job can run either on the main thread or on the libuv thread pool for the *_async variants.
+// A job returns an error message on failure and nullptr on success. Its output is returned
+// as a buffer unless the method passes a function that turns it into another JS value.
+typedef std::function<const char*(blobdata& output)> blob_job;
+typedef const char* (*blob_job_parser)(const Nan::FunctionCallbackInfo<v8::Value>& info, blob_job& job);
+typedef v8::Local<v8::Value> (*blob_job_result)(const blobdata& output);
 
-    v8::Isolate *isolate = v8::Isolate::GetCurrent();
-    Local<Object> target = info[0]->ToObject(isolate->GetCurrentContext()).ToLocalChecked();
-    if (!Buffer::HasInstance(target)) return THROW_ERROR_EXCEPTION("Argument should be a buffer object.");
+static v8::Local<v8::Value> blob_job_buffer(const blobdata& output) {
+    return Nan::CopyBuffer((char*)output.data(), output.size()).ToLocalChecked();
+}
 
-    blobdata input = std::string(Buffer::Data(target), Buffer::Length(target));
-    blobdata output = "";
+static void run_blob_job(const Nan::FunctionCallbackInfo<v8::Value>& info, blob_job_parser parse, blob_job_result result = blob_job_buffer) {
+    blob_job job;
+    const char* error = parse(info, job);
+    if (error) return THROW_ERROR_EXCEPTION(error);
+
+    // sync calls copy the result out, so the serialization buffer is kept for the next call
+    // on this thread. It is taken out while in use, a call made meanwhile starts a new one.
+    thread_local blobdata kept_output;
+    blobdata output;
+    output.swap(kept_output);
+    output.clear();
+    error = job(output);
+    if (!error) info.GetReturnValue().Set(result(output));
+    kept_output.swap(output);
+    if (error) return THROW_ERROR_EXCEPTION(error);
+}
 
-    enum BLOB_TYPE blob_type = BLOB_TYPE_CRYPTONOTE;
-    if (info.Length() >= 2) {
-        if (!info[1]->IsNumber()) return THROW_ERROR_EXCEPTION("Argument 2 should be a number");
-        blob_type = static_cast<enum BLOB_TYPE>(Nan::To<int>(info[1]).FromMaybe(0));
+class BlobJobWorker : public Nan::AsyncWorker {
+public:
+    BlobJobWorker(blob_job job, blob_job_result result, Local<Promise::Resolver> resolver) : Nan::AsyncWorker(nullptr, "cryptoforknote:BlobJobWorker"), m_job(std::move(job)), m_result(result) {
+        m_resolver.Reset(resolver);
     }
 
-    block b = AUTO_VAL_INIT(b);
-    b.set_blob_type(blob_type);
-    if (!parse_and_validate_block_from_blob(input, b)) return THROW_ERROR_EXCEPTION("Failed to parse block 2");
+    ~BlobJobWorker() {
+        m_resolver.Reset();
+    }
 
-    if (blob_type == BLOB_TYPE_FORKNOTE2) {
-        block parent_block;
-        if (!construct_parent_block(b, parent_block)) return THROW_ERROR_EXCEPTION("convert_blob: Failed to construct parent block");
-        if (!get_block_hashing_blob(parent_block, output)) return THROW_ERROR_EXCEPTION("convert_blob: Failed to create mining block");
-    } else {
-        if (!get_block_hashing_blob(b, output)) return THROW_ERROR_EXCEPTION("convert_blob: Failed to create mining block");
+    void Execute() {
+        const char* error = m_job(m_output);
+        if (error) SetErrorMessage(error);
     }
 
-    v8::Local<v8::Value> returnValue = Nan::CopyBuffer((char*)output.data(), output.size()).ToLocalChecked();
-    info.GetReturnValue().Set(returnValue);
+protected:
+    void HandleOKCallback() {
+        Nan::HandleScope scope;
+        Nan::New(m_resolver)->Resolve(Nan::GetCurrentContext(), m_result(m_output)).FromJust();
+    }
+
+    void HandleErrorCallback() {
+        Nan::HandleScope scope;
+        Nan::New(m_resolver)->Reject(Nan::GetCurrentContext(), Nan::Error(ErrorMessage())).FromJust();
+    }
+
+private:
+    blob_job m_job;
+    blob_job_result m_result;
+    blobdata m_output;
+    Nan::Persistent<Promise::Resolver> m_resolver;
+};
+
+static void queue_blob_job(const Nan::FunctionCallbackInfo<v8::Value>& info, blob_job_parser parse, blob_job_result result = blob_job_buffer) {
+    Local<Promise::Resolver> resolver = Promise::Resolver::New(Nan::GetCurrentContext()).ToLocalChecked();
+    info.GetReturnValue().Set(resolver->GetPromise());
+
+    blob_job job;
+    const char* error = parse(info, job);
+    if (error) {
+        resolver->Reject(Nan::GetCurrentContext(), Nan::Error(error)).FromJust();
+        return;
+    }
+    Nan::AsyncQueueWorker(new BlobJobWorker(std::move(job), result, resolver));
 }
 
-NAN_METHOD(get_block_id) {
-    if (info.Length() < 1) return THROW_ERROR_EXCEPTION("You must provide one argument.");
+static const char* read_blob_type(const Nan::FunctionCallbackInfo<v8::Value>& info, const int index, enum BLOB_TYPE& blob_type) {
+    blob_type = BLOB_TYPE_CRYPTONOTE;
+    if (info.Length() > index) {
+        if (!info[index]->IsNumber()) return index == 1 ? "Argument 2 should be a number" : "Argument 3 should be a number";
+        blob_type = static_cast<enum BLOB_TYPE>(Nan::To<int>(info[index]).FromMaybe(0));
+    }
+    return nullptr;
+}
+
+// Block the blob jobs of this thread parse into. Clearing it keeps the capacity of its vectors,
+// so parsing templates of the usual shape does not allocate them again.
+static block& thread_block(const enum BLOB_TYPE blob_type) {
+    thread_local block b = AUTO_VAL_INIT(b);
+    b.miner_tx.set_null();
+    if (!b.protocol_tx.empty()) b.protocol_tx->set_null();
+    b.tx_hashes.clear();
+    b.uncle = null_hash;
+    b.set_blob_type(blob_type);
+    return b;
+}
+
+static const char* convert_blob_job(const Nan::FunctionCallbackInfo<v8::Value>& info, blob_job& job) { // (parentBlockBuffer, cnBlobType)
+    if (info.Length() < 1) return "You must provide one argument.";
 
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     Local<Object> target = info[0]->ToObject(isolate->GetCurrentContext()).ToLocalChecked();
-    if (!Buffer::HasInstance(target)) return THROW_ERROR_EXCEPTION("Argument should be a buffer object.");
+    if (!Buffer::HasInstance(target)) return "Argument should be a buffer object.";
 
     blobdata input = std::string(Buffer::Data(target), Buffer::Length(target));
 
-    enum BLOB_TYPE blob_type = BLOB_TYPE_CRYPTONOTE;
-    if (info.Length() >= 2) {
-        if (!info[1]->IsNumber()) return THROW_ERROR_EXCEPTION("Argument 2 should be a number");
-        blob_type = static_cast<enum BLOB_TYPE>(Nan::To<int>(info[1]).FromMaybe(0));
+    enum BLOB_TYPE blob_type;
+    if (const char* error = read_blob_type(info, 1, blob_type)) return error;
+
+    job = [input, blob_type](blobdata& output) -> const char* {
+        block& b = thread_block(blob_type);
+        if (!parse_and_validate_block_from_blob(input, b)) return "Failed to parse block 2";
+
+        if (blob_type == BLOB_TYPE_FORKNOTE2) {
+            block parent_block;
+            if (!construct_parent_block(b, parent_block)) return "convert_blob: Failed to construct parent block";
+            if (!get_block_hashing_blob(parent_block, output)) return "convert_blob: Failed to create mining block";
+        } else {
+            if (!get_block_hashing_blob(b, output)) return "convert_blob: Failed to create mining block";
+        }
+        return nullptr;
+    };
+    return nullptr;
+}
+
+NAN_METHOD(convert_blob) { run_blob_job(info, convert_blob_job); }
+NAN_METHOD(convert_blob_async) { queue_blob_job(info, convert_blob_job); }
+
+static const char* get_block_id_job(const Nan::FunctionCallbackInfo<v8::Value>& info, blob_job& job) { // (blockBuffer, cnBlobType)
+    if (info.Length() < 1) return "You must provide one argument.";
+
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    Local<Object> target = info[0]->ToObject(isolate->GetCurrentContext()).ToLocalChecked();
+    if (!Buffer::HasInstance(target)) return "Argument should be a buffer object.";
+
+    blobdata input = std::string(Buffer::Data(target), Buffer::Length(target));
+
+    enum BLOB_TYPE blob_type;
+    if (const char* error = read_blob_type(info, 1, blob_type)) return error;
+
+    job = [input, blob_type](blobdata& output) -> const char* {
+        block& b = thread_block(blob_type);
+        if (!parse_and_validate_block_from_blob(input, b)) return "Failed to parse block";
+
+        crypto::hash block_id;
+        if (!get_block_hash(b, block_id)) return "Failed to calculate hash for block";
+
+        output = std::string(reinterpret_cast<char*>(&block_id), sizeof(block_id));
+        return nullptr;
+    };
+    return nullptr;
+}
+
+NAN_METHOD(get_block_id) { run_blob_job(info, get_block_id_job); }
+NAN_METHOD(get_block_id_async) { queue_blob_job(info, get_block_id_job); }
+
+static void read_block_cycle(const enum BLOB_TYPE blob_type, const Local<Value>& arg, std::vector<uint32_t>& cycle_data) {
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    Local<Array> cycle = Local<Array>::Cast(arg);
+    switch (blob_type) {
+        case BLOB_TYPE_CRYPTONOTE_XTNC:
+        case BLOB_TYPE_CRYPTONOTE_CUCKOO: cycle_data.resize(32); break;
+        case BLOB_TYPE_CRYPTONOTE_TUBE:   cycle_data.resize(40); break;
+        case BLOB_TYPE_CRYPTONOTE_XTA:    cycle_data.resize(48); break;
+        default:                          cycle_data.clear();
     }
+    for (size_t i = 0; i < cycle_data.size(); i++ ) cycle_data[i] = cycle->Get(isolate->GetCurrentContext(), i).ToLocalChecked()->NumberValue(isolate->GetCurrentContext()).ToChecked();
+}
 
-    block b = AUTO_VAL_INIT(b);
-    b.set_blob_type(blob_type);
-    if (!parse_and_validate_block_from_blob(input, b)) return THROW_ERROR_EXCEPTION("Failed to parse block");
+static void set_block_cycle(block& b, const std::vector<uint32_t>& cycle_data) {
+    switch (b.blob_type) {
+        case BLOB_TYPE_CRYPTONOTE_XTNC:
+        case BLOB_TYPE_CRYPTONOTE_CUCKOO: std::copy(cycle_data.begin(), cycle_data.end(), b.cycle.data);   break;
+        case BLOB_TYPE_CRYPTONOTE_TUBE:   std::copy(cycle_data.begin(), cycle_data.end(), b.cycle40.data); break;
+        case BLOB_TYPE_CRYPTONOTE_XTA:    std::copy(cycle_data.begin(), cycle_data.end(), b.cycle48.data); break;
+        default: break;
+    }
+}
 
-    crypto::hash block_id;
-    if (!get_block_hash(b, block_id)) return THROW_ERROR_EXCEPTION("Failed to calculate hash for block");
+static bool has_block_cycle(const enum BLOB_TYPE blob_type) {
+    return blob_type == BLOB_TYPE_CRYPTONOTE_XTNC || blob_type == BLOB_TYPE_CRYPTONOTE_CUCKOO || blob_type == BLOB_TYPE_CRYPTONOTE_TUBE || blob_type == BLOB_TYPE_CRYPTONOTE_XTA;
+}
 
-    char *cstr = reinterpret_cast<char*>(&block_id);
-    v8::Local<v8::Value> returnValue = Nan::CopyBuffer(cstr, 32).ToLocalChecked();
-    info.GetReturnValue().Set(returnValue);
+static bool set_block_nonce(block& b, const uint64_t nonce) {
+    b.nonce = nonce;
+    if (b.blob_type == BLOB_TYPE_FORKNOTE2) {
+        block parent_block;
+        b.parent_block->nonce = nonce;
+        if (!construct_parent_block(b, parent_block)) return false;
+        if (!mergeBlocks(parent_block, b, std::vector<crypto::hash>())) return false;
+    }
+    return true;
 }
 
-NAN_METHOD(construct_block_blob) { // (parentBlockTemplateBuffer, nonceBuffer, cnBlobType)
-    if (info.Length() < 2) return THROW_ERROR_EXCEPTION("You must provide two arguments.");
+// writes the 2 * size hex digits of data to hex, the two must not overlap
+static void hex_encode(const char* data, const size_t size, char* hex) {
+    static const char digits[] = "0123456789abcdef";
+    for (size_t i = 0; i != size; ++i) {
+        hex[2 * i]     = digits[static_cast<uint8_t>(data[i]) >> 4];
+        hex[2 * i + 1] = digits[static_cast<uint8_t>(data[i]) & 0x0f];
+    }
+}
+
+// found blocks also get their id and the hex of both appended, see found_block_value
+static const char* construct_block_job(const Nan::FunctionCallbackInfo<v8::Value>& info, blob_job& job, const bool found) { // (parentBlockTemplateBuffer, nonceBuffer, cnBlobType, cycle)
+    if (info.Length() < 2) return "You must provide two arguments.";
 
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     Local<Object> block_template_buf = info[0]->ToObject(isolate->GetCurrentContext()).ToLocalChecked();
     Local<Object> nonce_buf = info[1]->ToObject(isolate->GetCurrentContext()).ToLocalChecked();
 
-    if (!Buffer::HasInstance(block_template_buf) || !Buffer::HasInstance(nonce_buf)) return THROW_ERROR_EXCEPTION("Both arguments should be buffer objects.");
+    if (!Buffer::HasInstance(block_template_buf) || !Buffer::HasInstance(nonce_buf)) return "Both arguments should be buffer objects.";
 
-    enum BLOB_TYPE blob_type = BLOB_TYPE_CRYPTONOTE;
-    if (info.Length() >= 3) {
-        if (!info[2]->IsNumber()) return THROW_ERROR_EXCEPTION("Argument 3 should be a number");
-        blob_type = static_cast<enum BLOB_TYPE>(Nan::To<int>(info[2]).FromMaybe(0));
-    }
+    enum BLOB_TYPE blob_type;
+    if (const char* error = read_blob_type(info, 2, blob_type)) return error;
 
-    if (Buffer::Length(nonce_buf) != (blob_type == BLOB_TYPE_AEON ? 8 : 4)) return THROW_ERROR_EXCEPTION("Nonce buffer has invalid size.");
+    if (Buffer::Length(nonce_buf) != (blob_type == BLOB_TYPE_AEON ? 8 : 4)) return "Nonce buffer has invalid size.";
 
     uint64_t nonce = blob_type == BLOB_TYPE_AEON ? *reinterpret_cast<uint64_t*>(Buffer::Data(nonce_buf)) : *reinterpret_cast<uint32_t*>(Buffer::Data(nonce_buf));
     blobdata block_template_blob = std::string(Buffer::Data(block_template_buf), Buffer::Length(block_template_buf));
-    blobdata output = "";
-
-    block b = AUTO_VAL_INIT(b);
-    b.set_blob_type(blob_type);
-    if (!parse_and_validate_block_from_blob(block_template_blob, b)) return THROW_ERROR_EXCEPTION("Failed to parse block");
 
-    b.nonce = nonce;
-    if (blob_type == BLOB_TYPE_FORKNOTE2) {
-        block parent_block;
-        b.parent_block.nonce = nonce;
-        if (!construct_parent_block(b, parent_block)) return THROW_ERROR_EXCEPTION("Failed to construct parent block");
-        if (!mergeBlocks(parent_block, b, std::vector<crypto::hash>())) return THROW_ERROR_EXCEPTION("Failed to postprocess mining block");
+    std::vector<uint32_t> cycle;
+    if (has_block_cycle(blob_type)) {
+        if (info.Length() != 4) return "You must provide 4 arguments.";
+        read_block_cycle(blob_type, info[3], cycle);
     }
 
-    if (blob_type == BLOB_TYPE_CRYPTONOTE_XTNC || blob_type == BLOB_TYPE_CRYPTONOTE_CUCKOO) {
-        if (info.Length() != 4) return THROW_ERROR_EXCEPTION("You must provide 4 arguments.");
-        Local<Array> cycle = Local<Array>::Cast(info[3]);
-        for (int i = 0; i < 32; i++ ) b.cycle.data[i] = cycle->Get(isolate->GetCurrentContext(), i).ToLocalChecked()->NumberValue(isolate->GetCurrentContext()).ToChecked();
-    }
+    job = [block_template_blob, blob_type, nonce, cycle, found](blobdata& output) -> const char* {
+        block& b = thread_block(blob_type);
+        if (!parse_and_validate_block_from_blob(block_template_blob, b)) return "Failed to parse block";
+
+        if (!set_block_nonce(b, nonce)) return "Failed to postprocess mining block";
+        set_block_cycle(b, cycle);
+
+        if (!block_to_blob(b, output)) return "Failed to convert block to blob";
+        if (!found) return nullptr;
+
+        crypto::hash block_id;
+        if (!get_block_hash(b, block_id)) return "Failed to calculate hash for block";
+        // sized once so the hex goes to the tail while the raw bytes stay put at the front
+        const size_t raw_size = output.size() + sizeof(block_id);
+        output.resize(3 * raw_size);
+        memcpy(&output[raw_size - sizeof(block_id)], &block_id, sizeof(block_id));
+        hex_encode(&output[0], raw_size, &output[raw_size]);
+        return nullptr;
+    };
+    return nullptr;
+}
 
-    if (blob_type == BLOB_TYPE_CRYPTONOTE_TUBE) {
-        if (info.Length() != 4) return THROW_ERROR_EXCEPTION("You must provide 4 arguments.");
-        Local<Array> cycle = Local<Array>::Cast(info[3]);
-        for (int i = 0; i < 40; i++ ) b.cycle40.data[i] = cycle->Get(isolate->GetCurrentContext(), i).ToLocalChecked()->NumberValue(isolate->GetCurrentContext()).ToChecked();
-    }
+static const char* construct_block_blob_job(const Nan::FunctionCallbackInfo<v8::Value>& info, blob_job& job) {
+    return construct_block_job(info, job, false);
+}
 
-    if (blob_type == BLOB_TYPE_CRYPTONOTE_XTA) {
-        if (info.Length() != 4) return THROW_ERROR_EXCEPTION("You must provide 4 arguments.");
-        Local<Array> cycle = Local<Array>::Cast(info[3]);
-        for (int i = 0; i < 48; i++ ) b.cycle48.data[i] = cycle->Get(isolate->GetCurrentContext(), i).ToLocalChecked()->NumberValue(isolate->GetCurrentContext()).ToChecked();
-    }
+static const char* construct_found_block_job(const Nan::FunctionCallbackInfo<v8::Value>& info, blob_job& job) {
+    return construct_block_job(info, job, true);
+}
 
-    if (!block_to_blob(b, output)) return THROW_ERROR_EXCEPTION("Failed to convert block to blob");
+// splits blob + id + hex(blob + id) into { blob, blobHex, id, idHex }
+static v8::Local<v8::Value> found_block_value(const blobdata& output) {
+    const size_t id_size = sizeof(crypto::hash);
+    const size_t blob_size = output.size() / 3 - id_size;
+    const char* hex = output.data() + blob_size + id_size;
+
+    Local<Object> returnValue = Nan::New<Object>();
+    Nan::Set(returnValue, Nan::New("blob").ToLocalChecked(), Nan::CopyBuffer(output.data(), blob_size).ToLocalChecked());
+    Nan::Set(returnValue, Nan::New("blobHex").ToLocalChecked(), Nan::New<v8::String>(hex, static_cast<int>(2 * blob_size)).ToLocalChecked());
+    Nan::Set(returnValue, Nan::New("id").ToLocalChecked(), Nan::CopyBuffer(output.data() + blob_size, id_size).ToLocalChecked());
+    Nan::Set(returnValue, Nan::New("idHex").ToLocalChecked(), Nan::New<v8::String>(hex + 2 * blob_size, static_cast<int>(2 * id_size)).ToLocalChecked());
+    return returnValue;
+}
 
-    v8::Local<v8::Value> returnValue = Nan::CopyBuffer((char*)output.data(), output.size()).ToLocalChecked();
-    info.GetReturnValue().Set(returnValue);
+NAN_METHOD(construct_block_blob) { run_blob_job(info, construct_block_blob_job); }
+NAN_METHOD(construct_block_blob_async) { queue_blob_job(info, construct_block_blob_job); }
+NAN_METHOD(construct_found_block) { run_blob_job(info, construct_found_block_job, found_block_value); }
+NAN_METHOD(construct_found_block_async) { queue_blob_job(info, construct_found_block_job, found_block_value); }
+
+struct address_decode_result {
+    bool decoded;
+    uint64_t prefix;
+    bool valid;
+    blobdata data;  // prefixed raw address data when it is not a valid public address
+};
+
+static address_decode_result decode_address(const blobdata& input) {
+    address_decode_result result = { false, 0, false, "" };
+    blobdata data;
+    if (!tools::base58::decode_addr(input, result.prefix, data)) return result;
+    result.decoded = true;
+
+    account_public_address adr;
+    result.valid = ::serialization::parse_binary(data, adr) && crypto::check_key(adr.m_spend_public_key) && crypto::check_key(adr.m_view_public_key);
+    if (!result.valid && data.length()) result.data = uint64be_to_blob(result.prefix) + data;
+    return result;
+}
+
+static Local<Value> address_decode_value(const address_decode_result& result) {
+    if (!result.decoded) return Nan::Undefined();
+    if (result.valid) return Nan::New(static_cast<uint32_t>(result.prefix));
+    if (result.data.empty()) return Nan::Undefined();
+    return Nan::CopyBuffer((char*)result.data.data(), result.data.size()).ToLocalChecked();
 }
 
 NAN_METHOD(address_decode) {
@@ -253,25 +436,7 @@ NAN_METHOD(address_decode) {
     
     blobdata input = std::string(Buffer::Data(target), Buffer::Length(target));
 
-    blobdata data;
-    uint64_t prefix;
-    if (!tools::base58::decode_addr(input, prefix, data)) {
-        info.GetReturnValue().Set(Nan::Undefined());
-        return;
-    }
-
-    account_public_address adr;
-    if (!::serialization::parse_binary(data, adr) || !crypto::check_key(adr.m_spend_public_key) || !crypto::check_key(adr.m_view_public_key)) {
-        if (!data.length()) {
-            info.GetReturnValue().Set(Nan::Undefined());
-            return;
-        }
-        data = uint64be_to_blob(prefix) + data;
-        v8::Local<v8::Value> returnValue = Nan::CopyBuffer((char*)data.data(), data.size()).ToLocalChecked();
-        info.GetReturnValue().Set(returnValue);
-    } else {
-        info.GetReturnValue().Set(Nan::New(static_cast<uint32_t>(prefix)));
-    }
+    info.GetReturnValue().Set(address_decode_value(decode_address(input)));
 }
 
 NAN_METHOD(address_decode_integrated) {
@@ -310,83 +475,653 @@ NAN_METHOD(get_merged_mining_nonce_size) {
     info.GetReturnValue().Set(returnValue);
 }
 
-NAN_METHOD(construct_mm_parent_block_blob) { // (parentBlockTemplate, blob_type, childBlockTemplate)
-    if (info.Length() < 3) return THROW_ERROR_EXCEPTION("You must provide three arguments (parentBlock, blob_type, childBlock).");
+static const char* construct_mm_parent_block_blob_job(const Nan::FunctionCallbackInfo<v8::Value>& info, blob_job& job) { // (parentBlockTemplate, blob_type, childBlockTemplate)
+    if (info.Length() < 3) return "You must provide three arguments (parentBlock, blob_type, childBlock).";
 
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     Local<Object> target = info[0]->ToObject(isolate->GetCurrentContext()).ToLocalChecked();
     Local<Object> child_target = info[2]->ToObject(isolate->GetCurrentContext()).ToLocalChecked();
 
-    if (!Buffer::HasInstance(target)) return THROW_ERROR_EXCEPTION("First argument should be a buffer object.");
-    if (!info[1]->IsNumber()) return THROW_ERROR_EXCEPTION("Second argument should be a number");
-    if (!Buffer::HasInstance(child_target)) return THROW_ERROR_EXCEPTION("Third argument should be a buffer object.");
+    if (!Buffer::HasInstance(target)) return "First argument should be a buffer object.";
+    if (!info[1]->IsNumber()) return "Second argument should be a number";
+    if (!Buffer::HasInstance(child_target)) return "Third argument should be a buffer object.";
 
     const enum BLOB_TYPE blob_type = static_cast<enum BLOB_TYPE>(Nan::To<int>(info[1]).FromMaybe(0));
 
     blobdata input       = std::string(Buffer::Data(target), Buffer::Length(target));
     blobdata child_input = std::string(Buffer::Data(child_target), Buffer::Length(child_target));
 
-    block b = AUTO_VAL_INIT(b);
-    b.set_blob_type(blob_type);
-    if (!parse_and_validate_block_from_blob(input, b)) return THROW_ERROR_EXCEPTION("construct_mm_parent_block_blob: Failed to parse prent block");
-    if (blob_type == BLOB_TYPE_CRYPTONOTE_LOKI || blob_type == BLOB_TYPE_CRYPTONOTE_XTNC) b.miner_tx.version = cryptonote::loki_version_2;
-  
-    block b2 = AUTO_VAL_INIT(b2);
-    b2.set_blob_type(BLOB_TYPE_FORKNOTE2);
-    if (!parse_and_validate_block_from_blob(child_input, b2)) return THROW_ERROR_EXCEPTION("construct_mm_parent_block_blob: Failed to parse child block");
+    job = [input, blob_type, child_input](blobdata& output) -> const char* {
+        block& b = thread_block(blob_type);
+        if (!parse_and_validate_block_from_blob(input, b)) return "construct_mm_parent_block_blob: Failed to parse prent block";
+        if (blob_type == BLOB_TYPE_CRYPTONOTE_LOKI || blob_type == BLOB_TYPE_CRYPTONOTE_XTNC) b.miner_tx.version = cryptonote::loki_version_2;
 
-    if (!fillExtraMM(b, b2)) return THROW_ERROR_EXCEPTION("construct_mm_parent_block_blob: Failed to add merged mining tag to parent block extra");
+        block b2 = AUTO_VAL_INIT(b2);
+        b2.set_blob_type(BLOB_TYPE_FORKNOTE2);
+        if (!parse_and_validate_block_from_blob(child_input, b2)) return "construct_mm_parent_block_blob: Failed to parse child block";
 
-    blobdata output = "";
-    if (!block_to_blob(b, output)) return THROW_ERROR_EXCEPTION("construct_mm_parent_block_blob: Failed to convert child block to blob");
+        if (!fillExtraMM(b, b2)) return "construct_mm_parent_block_blob: Failed to add merged mining tag to parent block extra";
 
-    v8::Local<v8::Value> returnValue = Nan::CopyBuffer((char*)output.data(), output.size()).ToLocalChecked();
-    info.GetReturnValue().Set(returnValue);
+        if (!block_to_blob(b, output)) return "construct_mm_parent_block_blob: Failed to convert child block to blob";
+        return nullptr;
+    };
+    return nullptr;
 }
 
-NAN_METHOD(construct_mm_child_block_blob) { // (shareBuffer, blob_type, childBlockTemplate)
-    if (info.Length() < 3) return THROW_ERROR_EXCEPTION("You must provide three arguments (shareBuffer, blob_type, block2).");
+NAN_METHOD(construct_mm_parent_block_blob) { run_blob_job(info, construct_mm_parent_block_blob_job); }
+NAN_METHOD(construct_mm_parent_block_blob_async) { queue_blob_job(info, construct_mm_parent_block_blob_job); }
+
+static const char* construct_mm_child_block_blob_job(const Nan::FunctionCallbackInfo<v8::Value>& info, blob_job& job) { // (shareBuffer, blob_type, childBlockTemplate)
+    if (info.Length() < 3) return "You must provide three arguments (shareBuffer, blob_type, block2).";
 
     v8::Isolate *isolate = v8::Isolate::GetCurrent();
     Local<Object> block_template_buf = info[0]->ToObject(isolate->GetCurrentContext()).ToLocalChecked();
     Local<Object> child_block_template_buf = info[2]->ToObject(isolate->GetCurrentContext()).ToLocalChecked();
 
-    if (!Buffer::HasInstance(block_template_buf)) return THROW_ERROR_EXCEPTION("First argument should be a buffer object.");
-    if (!info[1]->IsNumber()) return THROW_ERROR_EXCEPTION("Second argument should be a number");
-    if (!Buffer::HasInstance(child_block_template_buf)) return THROW_ERROR_EXCEPTION("Third argument should be a buffer object.");
+    if (!Buffer::HasInstance(block_template_buf)) return "First argument should be a buffer object.";
+    if (!info[1]->IsNumber()) return "Second argument should be a number";
+    if (!Buffer::HasInstance(child_block_template_buf)) return "Third argument should be a buffer object.";
 
     const enum BLOB_TYPE blob_type = static_cast<enum BLOB_TYPE>(Nan::To<int>(info[1]).FromMaybe(0));
 
     blobdata block_template_blob = std::string(Buffer::Data(block_template_buf), Buffer::Length(block_template_buf));
     blobdata child_block_template_blob = std::string(Buffer::Data(child_block_template_buf), Buffer::Length(child_block_template_buf));
 
-    block b = AUTO_VAL_INIT(b);
-    b.set_blob_type(blob_type);
-    if (!parse_and_validate_block_from_blob(block_template_blob, b)) return THROW_ERROR_EXCEPTION("construct_mm_child_block_blob: Failed to parse parent block");
+    job = [block_template_blob, blob_type, child_block_template_blob](blobdata& output) -> const char* {
+        block& b = thread_block(blob_type);
+        if (!parse_and_validate_block_from_blob(block_template_blob, b)) return "construct_mm_child_block_blob: Failed to parse parent block";
 
-    block b2 = AUTO_VAL_INIT(b2);
-    b2.set_blob_type(BLOB_TYPE_FORKNOTE2);
-    if (!parse_and_validate_block_from_blob(child_block_template_blob, b2)) return THROW_ERROR_EXCEPTION("construct_mm_child_block_blob: Failed to parse child block");
+        block b2 = AUTO_VAL_INIT(b2);
+        b2.set_blob_type(BLOB_TYPE_FORKNOTE2);
+        if (!parse_and_validate_block_from_blob(child_block_template_blob, b2)) return "construct_mm_child_block_blob: Failed to parse child block";
 
-    if (!mergeBlocks(b, b2, std::vector<crypto::hash>())) return THROW_ERROR_EXCEPTION("construct_mm_child_block_blob: Failed to postprocess mining block");
-    
-    blobdata output = "";
-    if (!block_to_blob(b2, output)) return THROW_ERROR_EXCEPTION("construct_mm_child_block_blob: Failed to convert child block to blob");
+        if (!mergeBlocks(b, b2, std::vector<crypto::hash>())) return "construct_mm_child_block_blob: Failed to postprocess mining block";
+
+        if (!block_to_blob(b2, output)) return "construct_mm_child_block_blob: Failed to convert child block to blob";
+        return nullptr;
+    };
+    return nullptr;
+}
 
-    v8::Local<v8::Value> returnValue = Nan::CopyBuffer((char*)output.data(), output.size()).ToLocalChecked();
+NAN_METHOD(construct_mm_child_block_blob) { run_blob_job(info, construct_mm_child_block_blob_job); }
+NAN_METHOD(construct_mm_child_block_blob_async) { queue_blob_job(info, construct_mm_child_block_blob_job); }
+
+// Block template parsed once and kept alive between shares. It is never changed after
+// parsing: per-miner extra nonces go into the midstate or a copy of the parsed block
+// instead of patching and re-parsing the blob.
+struct block_template {
+    block b;
+    size_t extra_nonce_pos;  // index in b.miner_tx.extra matching the template reserved offset
+    bool has_reserved_offset;
+    std::vector<crypto::hash> tx_tree_branch; // merkle branch of the miner tx, fixed per template
+    bool has_miner_tx_midstate;
+    tx_hash_midstate miner_tx_midstate;       // miner tx hashing state up to the reserved offset
+    block_layout layout;     // offsets of the fields blockBlob changes
+    bool patch_blob;         // blockBlob patches a copy of blob instead of serializing b
+    blobdata blob;
+
+    block_template() : b(AUTO_VAL_INIT(b)), extra_nonce_pos(0), has_reserved_offset(false), has_miner_tx_midstate(false), patch_blob(false) {}
+};
+
+static bool parse_block_template(const blobdata& input, const enum BLOB_TYPE blob_type, const size_t reserved_offset, block_template& tmpl) {
+    tmpl.b.set_blob_type(blob_type);
+    if (!parse_and_validate_block_from_blob(input, tmpl.b)) return false;
+    get_tx_tree_branch(tmpl.b, tmpl.tx_tree_branch);
+    if (!get_block_layout(tmpl.b, tmpl.layout)) return false;
+    // merge mined blocks rewrite the merge mining tag of their parent block on every nonce,
+    // the others only need the template blob to come back unchanged from serialization
+    if (tmpl.b.blob_type != BLOB_TYPE_FORKNOTE2 && tmpl.layout.size == input.size()) {
+        tmpl.patch_blob = block_to_blob(tmpl.b, tmpl.blob) && tmpl.blob == input;
+        if (!tmpl.patch_blob) tmpl.blob.clear();
+    }
+    tmpl.has_reserved_offset = reserved_offset != 0;
+    if (!tmpl.has_reserved_offset) return true;
+
+    const std::vector<uint8_t>& extra = tmpl.b.miner_tx.extra;
+    const size_t extra_offset = tmpl.layout.miner_tx_extra;
+    if (extra.empty() || reserved_offset < extra_offset || reserved_offset >= extra_offset + extra.size()) return false;
+    tmpl.extra_nonce_pos = reserved_offset - extra_offset;
+    // merge mined blocks hash the parent block instead, they fall back to the full miner tx hash.
+    // The midstate only pays once a whole keccak block precedes the extra nonce: below that,
+    // resuming it costs as much as hashing the miner tx again.
+    if (tmpl.b.blob_type != BLOB_TYPE_FORKNOTE2) {
+        tmpl.has_miner_tx_midstate = get_transaction_hash_midstate(tmpl.b.miner_tx, tmpl.extra_nonce_pos, tmpl.miner_tx_midstate) &&
+                                     tmpl.miner_tx_midstate.absorbed != 0;
+    }
+    return true;
+}
+
+// b is a copy of the template block, the extra nonce goes over its reserved space
+static bool set_block_template_extra_nonce(const block_template& tmpl, block& b, const char* data, const size_t size) {
+    if (!size) return true;
+    std::vector<uint8_t>& extra = b.miner_tx.extra;
+    if (!tmpl.has_reserved_offset || tmpl.extra_nonce_pos + size > extra.size()) return false;
+    memcpy(extra.data() + tmpl.extra_nonce_pos, data, size);
+    return true;
+}
+
+// copies the template blob with the nonce, cycle and miner tx extra of b written over it
+static void patch_block_template_blob(const block_template& tmpl, const block& b, const std::vector<uint32_t>& cycle, blobdata& output) {
+    const block_layout& layout = tmpl.layout;
+    output = tmpl.blob;
+    memcpy(&output[layout.nonce], &b.nonce, layout.nonce_size);
+    if (layout.cycle != block_layout::npos && cycle.size() * sizeof(uint32_t) == layout.cycle_size) {
+        memcpy(&output[layout.cycle], cycle.data(), layout.cycle_size);
+    }
+    memcpy(&output[layout.miner_tx_extra], b.miner_tx.extra.data(), layout.miner_tx_extra_size);
+}
+
+// leaves the template untouched so batches can hash many extra nonces of one template in
+// parallel, an empty extra nonce hashes the template as it is
+static bool get_block_template_hashing_blob(const block_template& tmpl, const blobdata& extra_nonce, blobdata& output) {
+    if (tmpl.has_miner_tx_midstate) {
+        // only the extra bytes from the reserved offset on can differ from the template
+        if (tmpl.extra_nonce_pos + extra_nonce.size() > tmpl.b.miner_tx.extra.size()) return false;
+        crypto::hash miner_tx_hash;
+        if (!get_transaction_hash(tmpl.miner_tx_midstate, extra_nonce.data(), extra_nonce.size(), miner_tx_hash)) return false;
+        return get_block_hashing_blob(tmpl.b, get_tx_tree_hash(miner_tx_hash, tmpl.tx_tree_branch), output);
+    }
+    block b = tmpl.b;
+    if (!set_block_template_extra_nonce(tmpl, b, extra_nonce.data(), extra_nonce.size())) return false;
+    if (b.blob_type == BLOB_TYPE_FORKNOTE2) {
+        // merge mined blocks hash their parent block, its merge mining tag carries the miner tx
+        block parent_block;
+        if (!construct_parent_block(b, parent_block)) return false;
+        return get_block_hashing_blob(parent_block, output);
+    }
+    return get_block_hashing_blob(b, get_tx_tree_hash(b, tmpl.tx_tree_branch), output);
+}
+
+class BlockTemplate : public Nan::ObjectWrap {
+public:
+    static NAN_MODULE_INIT(Init) {
+        Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
+        tpl->SetClassName(Nan::New("BlockTemplate").ToLocalChecked());
+        tpl->InstanceTemplate()->SetInternalFieldCount(1);
+        Nan::SetPrototypeMethod(tpl, "hashingBlob", HashingBlob);
+        Nan::SetPrototypeMethod(tpl, "blockBlob", BlockBlob);
+        Nan::SetPrototypeMethod(tpl, "blockId", BlockId);
+        Nan::SetPrototypeMethod(tpl, "layout", Layout);
+        Nan::Set(target, Nan::New("BlockTemplate").ToLocalChecked(), Nan::GetFunction(tpl).ToLocalChecked());
+    }
+
+private:
+    block_template m_tmpl;
+    block m_block;     // the template as last completed by blockBlob, blockId hashes it
+    blobdata m_output; // reused by hashingBlob and blockBlob, the result is copied out
+
+    static NAN_METHOD(New) { // (blockTemplateBuffer, cnBlobType, reservedOffset)
+        if (!info.IsConstructCall()) return THROW_ERROR_EXCEPTION("BlockTemplate must be called with new.");
+        if (info.Length() < 1) return THROW_ERROR_EXCEPTION("You must provide one argument.");
+
+        v8::Isolate *isolate = v8::Isolate::GetCurrent();
+        Local<Object> target = info[0]->ToObject(isolate->GetCurrentContext()).ToLocalChecked();
+        if (!Buffer::HasInstance(target)) return THROW_ERROR_EXCEPTION("Argument should be a buffer object.");
+
+        enum BLOB_TYPE blob_type = BLOB_TYPE_CRYPTONOTE;
+        if (info.Length() >= 2) {
+            if (!info[1]->IsNumber()) return THROW_ERROR_EXCEPTION("Argument 2 should be a number");
+            blob_type = static_cast<enum BLOB_TYPE>(Nan::To<int>(info[1]).FromMaybe(0));
+        }
+
+        uint32_t reserved_offset = 0;
+        if (info.Length() >= 3 && !info[2]->IsUndefined()) {
+            if (!info[2]->IsNumber()) return THROW_ERROR_EXCEPTION("Argument 3 should be a number");
+            reserved_offset = Nan::To<uint32_t>(info[2]).FromMaybe(0);
+        }
+
+        blobdata input = std::string(Buffer::Data(target), Buffer::Length(target));
+
+        BlockTemplate* obj = new BlockTemplate();
+        if (!parse_block_template(input, blob_type, reserved_offset, obj->m_tmpl)) {
+            delete obj;
+            return THROW_ERROR_EXCEPTION("BlockTemplate: Failed to parse block template");
+        }
+        obj->m_block = obj->m_tmpl.b;
+        obj->Wrap(info.This());
+        info.GetReturnValue().Set(info.This());
+    }
+
+    // argument index as a buffer that fits the reserved space, left empty when not given so the template bytes stay
+    static bool ReadExtraNonce(BlockTemplate* obj, const Nan::FunctionCallbackInfo<v8::Value>& info, const int index, blobdata& extra_nonce) {
+        extra_nonce.clear();
+        if (info.Length() <= index || info[index]->IsUndefined()) return true;
+        Local<Object> extra_nonce_buf = info[index]->ToObject(v8::Isolate::GetCurrent()->GetCurrentContext()).ToLocalChecked();
+        if (!Buffer::HasInstance(extra_nonce_buf)) return false;
+        const size_t size = Buffer::Length(extra_nonce_buf);
+        if (size && (!obj->m_tmpl.has_reserved_offset || obj->m_tmpl.extra_nonce_pos + size > obj->m_tmpl.b.miner_tx.extra.size())) return false;
+        extra_nonce.assign(Buffer::Data(extra_nonce_buf), size);
+        return true;
+    }
+
+    static NAN_METHOD(HashingBlob) { // (extraNonceBuffer), the template is not changed
+        BlockTemplate* obj = Nan::ObjectWrap::Unwrap<BlockTemplate>(info.Holder());
+        blobdata extra_nonce;
+        if (!ReadExtraNonce(obj, info, 0, extra_nonce)) return THROW_ERROR_EXCEPTION("hashingBlob: Extra nonce should be a buffer that fits reserved space.");
+
+        blobdata& output = obj->m_output;
+        if (!get_block_template_hashing_blob(obj->m_tmpl, extra_nonce, output)) return THROW_ERROR_EXCEPTION("hashingBlob: Failed to create mining block");
+
+        v8::Local<v8::Value> returnValue = Nan::CopyBuffer((char*)output.data(), output.size()).ToLocalChecked();
+        info.GetReturnValue().Set(returnValue);
+    }
+
+    static NAN_METHOD(BlockBlob) { // (nonceBuffer, extraNonceBuffer, cycle), builds on a fresh copy of the template
+        BlockTemplate* obj = Nan::ObjectWrap::Unwrap<BlockTemplate>(info.Holder());
+        block& b = obj->m_block;
+        if (info.Length() < 1) return THROW_ERROR_EXCEPTION("You must provide one argument.");
+
+        Local<Object> nonce_buf = info[0]->ToObject(v8::Isolate::GetCurrent()->GetCurrentContext()).ToLocalChecked();
+        if (!Buffer::HasInstance(nonce_buf)) return THROW_ERROR_EXCEPTION("Nonce should be a buffer object.");
+        if (Buffer::Length(nonce_buf) != (obj->m_tmpl.b.blob_type == BLOB_TYPE_AEON ? 8 : 4)) return THROW_ERROR_EXCEPTION("Nonce buffer has invalid size.");
+        blobdata extra_nonce;
+        if (!ReadExtraNonce(obj, info, 1, extra_nonce)) return THROW_ERROR_EXCEPTION("blockBlob: Extra nonce should be a buffer that fits reserved space.");
+        b = obj->m_tmpl.b;
+        if (!set_block_template_extra_nonce(obj->m_tmpl, b, extra_nonce.data(), extra_nonce.size())) return THROW_ERROR_EXCEPTION("blockBlob: Failed to postprocess mining block");
+
+        uint64_t nonce = b.blob_type == BLOB_TYPE_AEON ? *reinterpret_cast<uint64_t*>(Buffer::Data(nonce_buf)) : *reinterpret_cast<uint32_t*>(Buffer::Data(nonce_buf));
+        if (!set_block_nonce(b, nonce)) return THROW_ERROR_EXCEPTION("blockBlob: Failed to postprocess mining block");
+
+        std::vector<uint32_t> cycle;
+        if (has_block_cycle(b.blob_type)) {
+            if (info.Length() < 3) return THROW_ERROR_EXCEPTION("You must provide 3 arguments.");
+            read_block_cycle(b.blob_type, info[2], cycle);
+            set_block_cycle(b, cycle);
+        }
+
+        blobdata& output = obj->m_output;
+        if (obj->m_tmpl.patch_blob) {
+            patch_block_template_blob(obj->m_tmpl, b, cycle, output);
+        } else if (!block_to_blob(b, output)) {
+            return THROW_ERROR_EXCEPTION("blockBlob: Failed to convert block to blob");
+        }
+
+        v8::Local<v8::Value> returnValue = Nan::CopyBuffer((char*)output.data(), output.size()).ToLocalChecked();
+        info.GetReturnValue().Set(returnValue);
+    }
+
+    static NAN_METHOD(BlockId) { // id of the block as last set up by blockBlob
+        BlockTemplate* obj = Nan::ObjectWrap::Unwrap<BlockTemplate>(info.Holder());
+
+        crypto::hash block_id;
+        if (!get_block_hash(obj->m_block, block_id)) return THROW_ERROR_EXCEPTION("blockId: Failed to calculate hash for block");
+
+        char *cstr = reinterpret_cast<char*>(&block_id);
+        v8::Local<v8::Value> returnValue = Nan::CopyBuffer(cstr, 32).ToLocalChecked();
+        info.GetReturnValue().Set(returnValue);
+    }
+
+    static NAN_METHOD(Layout) { // byte offsets in the block blob, fields the blob type lacks are left out
+        BlockTemplate* obj = Nan::ObjectWrap::Unwrap<BlockTemplate>(info.Holder());
+        const block_template& tmpl = obj->m_tmpl;
+        const block_layout& layout = tmpl.layout;
+
+        Local<Object> returnValue = Nan::New<Object>();
+        Nan::Set(returnValue, Nan::New("size").ToLocalChecked(), Nan::New(static_cast<uint32_t>(layout.size)));
+        if (layout.nonce != block_layout::npos) {
+            Nan::Set(returnValue, Nan::New("nonce").ToLocalChecked(), Nan::New(static_cast<uint32_t>(layout.nonce)));
+            Nan::Set(returnValue, Nan::New("nonceSize").ToLocalChecked(), Nan::New(static_cast<uint32_t>(layout.nonce_size)));
+        }
+        if (layout.cycle != block_layout::npos) {
+            Nan::Set(returnValue, Nan::New("cycle").ToLocalChecked(), Nan::New(static_cast<uint32_t>(layout.cycle)));
+            Nan::Set(returnValue, Nan::New("cycleSize").ToLocalChecked(), Nan::New(static_cast<uint32_t>(layout.cycle_size)));
+        }
+        Nan::Set(returnValue, Nan::New("minerTxExtra").ToLocalChecked(), Nan::New(static_cast<uint32_t>(layout.miner_tx_extra)));
+        Nan::Set(returnValue, Nan::New("minerTxExtraSize").ToLocalChecked(), Nan::New(static_cast<uint32_t>(layout.miner_tx_extra_size)));
+        if (tmpl.has_reserved_offset) {
+            Nan::Set(returnValue, Nan::New("reservedOffset").ToLocalChecked(), Nan::New(static_cast<uint32_t>(layout.miner_tx_extra + tmpl.extra_nonce_pos)));
+        }
+        Nan::Set(returnValue, Nan::New("txHashes").ToLocalChecked(), Nan::New(static_cast<uint32_t>(layout.tx_hashes)));
+        info.GetReturnValue().Set(returnValue);
+    }
+};
+
+static const char* convert_blob_batch_job(const Nan::FunctionCallbackInfo<v8::Value>& info, blob_job& job) { // (blockTemplateBuffer, cnBlobType, reservedOffset, extraNonceBuffers)
+    if (info.Length() < 4) return "You must provide four arguments (blockTemplate, blob_type, reservedOffset, extraNonces).";
+
+    v8::Isolate *isolate = v8::Isolate::GetCurrent();
+    Local<Object> target = info[0]->ToObject(isolate->GetCurrentContext()).ToLocalChecked();
+
+    if (!Buffer::HasInstance(target)) return "First argument should be a buffer object.";
+    if (!info[1]->IsNumber()) return "Second argument should be a number";
+    if (!info[2]->IsNumber()) return "Third argument should be a number";
+    if (!info[3]->IsArray()) return "Fourth argument should be an array of buffer objects.";
+
+    const enum BLOB_TYPE blob_type = static_cast<enum BLOB_TYPE>(Nan::To<int>(info[1]).FromMaybe(0));
+    const uint32_t reserved_offset = Nan::To<uint32_t>(info[2]).FromMaybe(0);
+    Local<Array> extra_nonce_bufs = Local<Array>::Cast(info[3]);
+
+    blobdata input = std::string(Buffer::Data(target), Buffer::Length(target));
+
+    std::vector<blobdata> extra_nonces(extra_nonce_bufs->Length());
+    for (uint32_t i = 0; i != extra_nonces.size(); ++i) {
+        Local<Value> extra_nonce = Nan::Get(extra_nonce_bufs, i).ToLocalChecked();
+        if (!Buffer::HasInstance(extra_nonce)) return "convert_blob_batch: Extra nonce should be a buffer object.";
+        extra_nonces[i] = std::string(Buffer::Data(extra_nonce), Buffer::Length(extra_nonce));
+    }
+
+    job = [input, blob_type, reserved_offset, extra_nonces](blobdata& output) -> const char* {
+        block_template tmpl;
+        if (!parse_block_template(input, blob_type, reserved_offset, tmpl)) return "convert_blob_batch: Failed to parse block template";
+
+        // hashing blobs of one template only differ in the merkle root so they share one size
+        if (tmpl.b.blob_type != BLOB_TYPE_FORKNOTE2 && !extra_nonces.empty()) {
+            blobdata hashing_blob = "";
+            if (!get_block_template_hashing_blob(tmpl, extra_nonces[0], hashing_blob)) return "convert_blob_batch: Extra nonce should fit reserved space.";
+            const size_t stride = hashing_blob.size();
+            output.resize(stride * extra_nonces.size());
+
+            std::atomic<const char*> error(nullptr);
+            tools::threadpool::instance().parallel_for(extra_nonces.size(), [&](size_t begin, size_t end) {
+                blobdata hashing_blob = "";
+                for (size_t i = begin; i != end; ++i) {
+                    if (!get_block_template_hashing_blob(tmpl, extra_nonces[i], hashing_blob)) error = "convert_blob_batch: Extra nonce should fit reserved space.";
+                    else if (hashing_blob.size() != stride) error = "convert_blob_batch: Hashing blob size changed within batch";
+                    else memcpy(&output[i * stride], hashing_blob.data(), stride);
+                }
+            });
+            return error;
+        }
+
+        // merge mined templates hash the parent block, those go one by one
+        size_t stride = 0;
+        for (size_t i = 0; i != extra_nonces.size(); ++i) {
+            blobdata hashing_blob = "";
+            if (!get_block_template_hashing_blob(tmpl, extra_nonces[i], hashing_blob)) return "convert_blob_batch: Extra nonce should fit reserved space.";
+            if (!i) {
+                stride = hashing_blob.size();
+                output.reserve(stride * extra_nonces.size());
+            } else if (hashing_blob.size() != stride) {
+                return "convert_blob_batch: Hashing blob size changed within batch";
+            }
+            output += hashing_blob;
+        }
+        return nullptr;
+    };
+    return nullptr;
+}
+
+NAN_METHOD(convert_blob_batch) { run_blob_job(info, convert_blob_batch_job); }
+NAN_METHOD(convert_blob_batch_async) { queue_blob_job(info, convert_blob_batch_job); }
+
+static const char* get_tx_hashes_job(const Nan::FunctionCallbackInfo<v8::Value>& info, blob_job& job) { // (txBuffers, cnBlobType)
+    if (info.Length() < 1) return "You must provide one argument.";
+    if (!info[0]->IsArray()) return "First argument should be an array of buffer objects.";
+
+    Local<Array> tx_bufs = Local<Array>::Cast(info[0]);
+    std::vector<blobdata> txs(tx_bufs->Length());
+    for (uint32_t i = 0; i != txs.size(); ++i) {
+        Local<Value> tx = Nan::Get(tx_bufs, i).ToLocalChecked();
+        if (!Buffer::HasInstance(tx)) return "get_tx_hashes: Transaction should be a buffer object.";
+        txs[i] = std::string(Buffer::Data(tx), Buffer::Length(tx));
+    }
+
+    enum BLOB_TYPE blob_type;
+    if (const char* error = read_blob_type(info, 1, blob_type)) return error;
+
+    job = [txs, blob_type](blobdata& output) -> const char* {
+        output.resize(txs.size() * sizeof(crypto::hash));
+        std::atomic<const char*> error(nullptr);
+        tools::threadpool::instance().parallel_for(txs.size(), [&](size_t begin, size_t end) {
+            transaction tx;
+            for (size_t i = begin; i != end; ++i) {
+                tx.set_null();
+                tx.blob_type = blob_type;
+                crypto::hash tx_hash;
+                if (!parse_and_validate_tx_from_blob(txs[i], tx)) error = "get_tx_hashes: Failed to parse transaction";
+                else if (!get_transaction_hash(tx, tx_hash, nullptr)) error = "get_tx_hashes: Failed to calculate hash for transaction";
+                else memcpy(&output[i * sizeof(crypto::hash)], &tx_hash, sizeof(crypto::hash));
+            }
+        });
+        return error;
+    };
+    return nullptr;
+}
+
+NAN_METHOD(get_tx_hashes) { run_blob_job(info, get_tx_hashes_job); }
+NAN_METHOD(get_tx_hashes_async) { queue_blob_job(info, get_tx_hashes_job); }
+
+static bool read_uint64(Local<Value> value, uint64_t& number) {
+    if (!value->IsNumber()) return false;
+    const double input = Nan::To<double>(value).FromMaybe(-1);
+    if (!(input >= 0 && input < 18446744073709551616.0)) return false;
+    number = static_cast<uint64_t>(input);
+    return true;
+}
+
+// a difficulty as a number or, for the ones past 2^53 that next_difficulty returns, a BigInt
+static bool read_difficulty(Local<Value> value, difficulty_type& difficulty) {
+    if (value->IsBigInt()) {
+        bool lossless;
+        difficulty = value.As<v8::BigInt>()->Uint64Value(&lossless);
+        return lossless;
+    }
+    return read_uint64(value, difficulty);
+}
+
+NAN_METHOD(check_hash) { // (hashBuffer, difficulty), true when the hash meets the difficulty
+    if (info.Length() < 2) return THROW_ERROR_EXCEPTION("You must provide two arguments.");
+    if (!Buffer::HasInstance(info[0]) || Buffer::Length(info[0]) != sizeof(crypto::hash)) return THROW_ERROR_EXCEPTION("First argument should be a 32 byte buffer object.");
+
+    difficulty_type difficulty;
+    if (!read_difficulty(info[1], difficulty)) return THROW_ERROR_EXCEPTION("Second argument should be a non-negative number or a BigInt");
+
+    crypto::hash hash;
+    memcpy(&hash, Buffer::Data(info[0]), sizeof(hash));
+    info.GetReturnValue().Set(cryptonote::check_hash(hash, difficulty));
+}
+
+static const char* check_hashes_job(const Nan::FunctionCallbackInfo<v8::Value>& info, blob_job& job) { // (hashesBuffer, difficulties), one difficulty for every hash or one array entry per hash
+    if (info.Length() < 2) return "You must provide two arguments.";
+    if (!Buffer::HasInstance(info[0])) return "First argument should be a buffer object.";
+    if (Buffer::Length(info[0]) % sizeof(crypto::hash)) return "check_hashes: Hashes buffer size should be a multiple of 32";
+    const size_t count = Buffer::Length(info[0]) / sizeof(crypto::hash);
+
+    std::vector<difficulty_type> difficulties(1);
+    if (info[1]->IsArray()) {
+        Local<Array> difficulty_values = Local<Array>::Cast(info[1]);
+        if (difficulty_values->Length() != count) return "check_hashes: Difficulties should have one entry per hash";
+        difficulties.resize(count);
+        for (uint32_t i = 0; i != count; ++i) {
+            if (!read_difficulty(Nan::Get(difficulty_values, i).ToLocalChecked(), difficulties[i])) return "check_hashes: Difficulty should be a non-negative number or a BigInt";
+        }
+    } else if (!read_difficulty(info[1], difficulties[0])) {
+        return "Second argument should be a non-negative number or an array of them";
+    }
+
+    std::string hashes(Buffer::Data(info[0]), Buffer::Length(info[0]));
+    job = [hashes, difficulties, count](blobdata& output) -> const char* { // bit i % 8 of byte i / 8 is set when hash i meets its difficulty
+        output.assign((count + 7) / 8, '\0');
+        crypto::hash hash;
+        for (size_t i = 0; i != count; ++i) {
+            memcpy(&hash, hashes.data() + i * sizeof(hash), sizeof(hash));
+            if (cryptonote::check_hash(hash, difficulties[difficulties.size() == 1 ? 0 : i])) output[i / 8] |= 1 << (i % 8);
+        }
+        return nullptr;
+    };
+    return nullptr;
+}
+
+NAN_METHOD(check_hashes) { run_blob_job(info, check_hashes_job); }
+NAN_METHOD(check_hashes_async) { queue_blob_job(info, check_hashes_job); }
+
+// cumulative difficulties are only subtracted, so a BigInt past 64 bits is taken modulo 2^64
+static bool read_cumulative_difficulty(Local<Value> value, difficulty_type& difficulty) {
+    if (value->IsBigInt()) {
+        difficulty = value.As<v8::BigInt>()->Uint64Value();
+        return true;
+    }
+    return read_uint64(value, difficulty);
+}
+
+// a BigInt as a Number would round difficulties past 2^53
+static Local<v8::BigInt> difficulty_value(const difficulty_type difficulty) {
+    return v8::BigInt::NewFromUnsigned(v8::Isolate::GetCurrent(), difficulty);
+}
+
+struct difficulty_params {
+    difficulty_algorithm algorithm;
+    uint32_t target_seconds;
+    uint32_t window;
+    uint32_t lag;
+    uint32_t cut;
+};
+
+// (algorithm, targetSeconds, window, lag, cut) from argument first on, undefined ones take the defaults of the algorithm
+static const char* read_difficulty_params(const Nan::FunctionCallbackInfo<v8::Value>& info, const int first, difficulty_params& params) {
+    uint32_t values[5];
+    bool given[5];
+    for (int i = 0; i != 5; ++i) {
+        given[i] = info.Length() > first + i && !info[first + i]->IsUndefined();
+        if (given[i] && !info[first + i]->IsNumber()) return "Difficulty settings should be numbers";
+        values[i] = given[i] ? Nan::To<uint32_t>(info[first + i]).FromMaybe(0) : 0;
+    }
+    if (values[0] != DIFFICULTY_ALGORITHM_CRYPTONOTE && values[0] != DIFFICULTY_ALGORITHM_LWMA) return "Unknown difficulty algorithm";
+    params.algorithm = static_cast<difficulty_algorithm>(values[0]);
+    const bool lwma = params.algorithm == DIFFICULTY_ALGORITHM_LWMA;
+    params.target_seconds = given[1] ? values[1] : DIFFICULTY_TARGET;
+    params.window = given[2] ? values[2] : lwma ? DIFFICULTY_WINDOW_LWMA : DIFFICULTY_WINDOW;
+    params.lag = lwma ? 0 : given[3] ? values[3] : DIFFICULTY_LAG;
+    params.cut = lwma ? 0 : given[4] ? values[4] : DIFFICULTY_CUT;
+    if (params.target_seconds == 0 || params.window == 0) return "Difficulty target and window should be positive";
+    if (!lwma && 2 * static_cast<uint64_t>(params.cut) + 2 > params.window) return "Difficulty window should be larger than twice the cut";
+    return nullptr;
+}
+
+NAN_METHOD(next_difficulty) { // (timestamps, cumulativeDifficulties, algorithm, targetSeconds, window, lag, cut), BigInt difficulty of the block after the last one given
+    if (info.Length() < 2) return THROW_ERROR_EXCEPTION("You must provide two arguments.");
+    if (!info[0]->IsArray() || !info[1]->IsArray()) return THROW_ERROR_EXCEPTION("Timestamps and cumulative difficulties should be arrays.");
+    Local<Array> timestamp_values = Local<Array>::Cast(info[0]);
+    Local<Array> difficulty_values = Local<Array>::Cast(info[1]);
+    if (timestamp_values->Length() != difficulty_values->Length()) return THROW_ERROR_EXCEPTION("next_difficulty: Timestamps and cumulative difficulties should have the same length");
+
+    difficulty_params params;
+    const char* error = read_difficulty_params(info, 2, params);
+    if (error) return THROW_ERROR_EXCEPTION(error);
+
+    // only the last blocks the algorithm looks at, older ones may be given as well
+    const bool lwma = params.algorithm == DIFFICULTY_ALGORITHM_LWMA;
+    const uint32_t length = timestamp_values->Length();
+    const uint32_t count = std::min<uint64_t>(length, lwma ? params.window + 1ull : params.window + static_cast<uint64_t>(params.lag));
+    std::vector<uint64_t> timestamps(count);
+    std::vector<difficulty_type> cumulative_difficulties(count);
+    for (uint32_t i = 0; i != count; ++i) {
+        if (!read_uint64(Nan::Get(timestamp_values, length - count + i).ToLocalChecked(), timestamps[i])) return THROW_ERROR_EXCEPTION("next_difficulty: Timestamp should be a non-negative number");
+        if (!read_cumulative_difficulty(Nan::Get(difficulty_values, length - count + i).ToLocalChecked(), cumulative_difficulties[i])) return THROW_ERROR_EXCEPTION("next_difficulty: Cumulative difficulty should be a non-negative number or a BigInt");
+    }
+
+    const difficulty_type difficulty = lwma
+        ? cryptonote::next_difficulty_lwma(timestamps, cumulative_difficulties, params.target_seconds, params.window)
+        : cryptonote::next_difficulty(std::move(timestamps), std::move(cumulative_difficulties), params.target_seconds, params.window, params.cut);
+    info.GetReturnValue().Set(difficulty_value(difficulty));
+}
+
+// next_difficulty over a chain fed one block at a time, each block updates the window in place
+class DifficultyWindow : public Nan::ObjectWrap {
+public:
+    static NAN_MODULE_INIT(Init) {
+        Local<FunctionTemplate> tpl = Nan::New<FunctionTemplate>(New);
+        tpl->SetClassName(Nan::New("DifficultyWindow").ToLocalChecked());
+        tpl->InstanceTemplate()->SetInternalFieldCount(1);
+        Nan::SetPrototypeMethod(tpl, "addBlock", AddBlock);
+        Nan::SetPrototypeMethod(tpl, "nextDifficulty", NextDifficulty);
+        Nan::Set(target, Nan::New("DifficultyWindow").ToLocalChecked(), Nan::GetFunction(tpl).ToLocalChecked());
+    }
+
+private:
+    explicit DifficultyWindow(const difficulty_params& params) : m_window(params.algorithm, params.target_seconds, params.window, params.lag, params.cut) {}
+
+    difficulty_window m_window;
+
+    static NAN_METHOD(New) { // (algorithm, targetSeconds, window, lag, cut), the settings of next_difficulty
+        if (!info.IsConstructCall()) return THROW_ERROR_EXCEPTION("DifficultyWindow must be called with new.");
+
+        difficulty_params params;
+        const char* error = read_difficulty_params(info, 0, params);
+        if (error) return THROW_ERROR_EXCEPTION(error);
+
+        DifficultyWindow* obj = new DifficultyWindow(params);
+        obj->Wrap(info.This());
+        info.GetReturnValue().Set(info.This());
+    }
+
+    static NAN_METHOD(AddBlock) { // (timestamp, cumulativeDifficulty)
+        DifficultyWindow* obj = Nan::ObjectWrap::Unwrap<DifficultyWindow>(info.Holder());
+        if (info.Length() < 2) return THROW_ERROR_EXCEPTION("You must provide two arguments.");
+
+        uint64_t timestamp;
+        difficulty_type cumulative_difficulty;
+        if (!read_uint64(info[0], timestamp)) return THROW_ERROR_EXCEPTION("addBlock: Timestamp should be a non-negative number");
+        if (!read_cumulative_difficulty(info[1], cumulative_difficulty)) return THROW_ERROR_EXCEPTION("addBlock: Cumulative difficulty should be a non-negative number or a BigInt");
+        obj->m_window.add_block(timestamp, cumulative_difficulty);
+    }
+
+    static NAN_METHOD(NextDifficulty) { // BigInt difficulty of the block after the last one added
+        DifficultyWindow* obj = Nan::ObjectWrap::Unwrap<DifficultyWindow>(info.Holder());
+        info.GetReturnValue().Set(difficulty_value(obj->m_window.next_difficulty()));
+    }
+};
+
+NAN_METHOD(address_decode_batch) { // (addressBuffers), same result per address as address_decode
+    if (info.Length() < 1) return THROW_ERROR_EXCEPTION("You must provide one argument.");
+    if (!info[0]->IsArray()) return THROW_ERROR_EXCEPTION("Argument should be an array of buffer objects.");
+
+    Local<Array> address_bufs = Local<Array>::Cast(info[0]);
+    std::vector<blobdata> addresses(address_bufs->Length());
+    for (uint32_t i = 0; i != addresses.size(); ++i) {
+        Local<Value> address = Nan::Get(address_bufs, i).ToLocalChecked();
+        if (!Buffer::HasInstance(address)) return THROW_ERROR_EXCEPTION("Address should be a buffer object.");
+        addresses[i] = std::string(Buffer::Data(address), Buffer::Length(address));
+    }
+
+    std::vector<address_decode_result> results(addresses.size());
+    tools::threadpool::instance().parallel_for(addresses.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i != end; ++i) results[i] = decode_address(addresses[i]);
+    });
+
+    Local<Array> returnValue = Nan::New<Array>(results.size());
+    for (uint32_t i = 0; i != results.size(); ++i) Nan::Set(returnValue, i, address_decode_value(results[i]));
     info.GetReturnValue().Set(returnValue);
 }
 
+NAN_METHOD(set_threads) { // (threads, pinThreads)
+    if (info.Length() < 1 || !info[0]->IsNumber()) return THROW_ERROR_EXCEPTION("Argument should be a number");
+    const bool pin_threads = info.Length() >= 2 && Nan::To<bool>(info[1]).FromMaybe(false);
+    // 0 and negative counts run inline, more than four threads per CPU are clamped
+    const int64_t threads = std::min<int64_t>(std::max<int64_t>(Nan::To<int64_t>(info[0]).FromMaybe(1), 1), tools::threadpool::max_threads());
+    tools::threadpool::instance().set_threads(static_cast<unsigned>(threads), pin_threads);
+}
+
 NAN_MODULE_INIT(init) {
     Nan::Set(target, Nan::New("construct_block_blob").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(construct_block_blob)).ToLocalChecked());
+    Nan::Set(target, Nan::New("construct_block_blob_async").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(construct_block_blob_async)).ToLocalChecked());
+    Nan::Set(target, Nan::New("construct_found_block").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(construct_found_block)).ToLocalChecked());
+    Nan::Set(target, Nan::New("construct_found_block_async").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(construct_found_block_async)).ToLocalChecked());
     Nan::Set(target, Nan::New("get_block_id").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(get_block_id)).ToLocalChecked());
+    Nan::Set(target, Nan::New("get_block_id_async").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(get_block_id_async)).ToLocalChecked());
     Nan::Set(target, Nan::New("convert_blob").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(convert_blob)).ToLocalChecked());
+    Nan::Set(target, Nan::New("convert_blob_async").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(convert_blob_async)).ToLocalChecked());
+    Nan::Set(target, Nan::New("convert_blob_batch").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(convert_blob_batch)).ToLocalChecked());
+    Nan::Set(target, Nan::New("convert_blob_batch_async").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(convert_blob_batch_async)).ToLocalChecked());
+    Nan::Set(target, Nan::New("get_tx_hashes").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(get_tx_hashes)).ToLocalChecked());
+    Nan::Set(target, Nan::New("get_tx_hashes_async").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(get_tx_hashes_async)).ToLocalChecked());
+    Nan::Set(target, Nan::New("check_hash").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(check_hash)).ToLocalChecked());
+    Nan::Set(target, Nan::New("check_hashes").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(check_hashes)).ToLocalChecked());
+    Nan::Set(target, Nan::New("check_hashes_async").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(check_hashes_async)).ToLocalChecked());
+    Nan::Set(target, Nan::New("next_difficulty").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(next_difficulty)).ToLocalChecked());
     Nan::Set(target, Nan::New("address_decode").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(address_decode)).ToLocalChecked());
+    Nan::Set(target, Nan::New("address_decode_batch").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(address_decode_batch)).ToLocalChecked());
     Nan::Set(target, Nan::New("address_decode_integrated").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(address_decode_integrated)).ToLocalChecked());
 
     Nan::Set(target, Nan::New("get_merged_mining_nonce_size").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(get_merged_mining_nonce_size)).ToLocalChecked());
     Nan::Set(target, Nan::New("construct_mm_parent_block_blob").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(construct_mm_parent_block_blob)).ToLocalChecked());
+    Nan::Set(target, Nan::New("construct_mm_parent_block_blob_async").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(construct_mm_parent_block_blob_async)).ToLocalChecked());
     Nan::Set(target, Nan::New("construct_mm_child_block_blob").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(construct_mm_child_block_blob)).ToLocalChecked());
+    Nan::Set(target, Nan::New("construct_mm_child_block_blob_async").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(construct_mm_child_block_blob_async)).ToLocalChecked());
+    Nan::Set(target, Nan::New("setThreads").ToLocalChecked(), Nan::GetFunction(Nan::New<FunctionTemplate>(set_threads)).ToLocalChecked());
+
+    BlockTemplate::Init(target);
+    DifficultyWindow::Init(target);
 }
 
 NODE_MODULE(cryptoforknote, init)
@@ -8,11 +8,15 @@
 #pragma once
 
 #include <cassert>
+#include <cstring>
 #include <iostream>
 #include <iterator>
+#include <limits>
+#include <string>
 #include <boost/type_traits/make_unsigned.hpp>
 
 #include "common/varint.h"
+#include "span.h"
 #include "warnings.h"
 
 PUSH_WARNINGS
@@ -20,39 +24,89 @@ DISABLE_VS_WARNINGS(4244)
 
 //TODO: fix size_t warning in x32 platform
 
-template <class Stream, bool IsSaving>
+template <bool W>
+struct binary_archive;
+
+template <bool IsSaving>
 struct binary_archive_base
 {
-  typedef Stream stream_type;
-  typedef binary_archive_base<Stream, IsSaving> base_type;
+  typedef binary_archive_base<IsSaving> base_type;
   typedef boost::mpl::bool_<IsSaving> is_saving;
 
   typedef uint8_t variant_tag_type;
-
-  explicit binary_archive_base(stream_type &s) : stream_(s) { }
+  // archive the VARIANT_TAG declarations are made for, every binary encoding shares them
+  typedef binary_archive<IsSaving> variant_tag_archive;
 
   void tag(const char *) { }
   void begin_object() { }
   void end_object() { }
   void begin_variant() { }
   void end_variant() { }
-  stream_type &stream() { return stream_; }
-protected:
-  stream_type &stream_;
 };
 
-template <bool W>
-struct binary_archive;
+/* Read position and error state of a memory backed binary_archive<false>. It answers
+ * the std::istream state queries (good/rdstate/setstate/clear/peek) that serializers
+ * make through ar.stream(). */
+class binary_input_stream
+{
+public:
+  binary_input_stream(const uint8_t *data, size_t size) : pos_(data), end_(data + size), state_(std::ios_base::goodbit) { }
+
+  bool good() const { return state_ == std::ios_base::goodbit; }
+  std::ios_base::iostate rdstate() const { return state_; }
+  void setstate(std::ios_base::iostate state) { state_ |= state; }
+  void clear(std::ios_base::iostate state = std::ios_base::goodbit) { state_ = state; }
+
+  int peek()
+  {
+    if (!good())
+      return EOF;
+    if (pos_ == end_)
+    {
+      state_ |= std::ios_base::eofbit;
+      return EOF;
+    }
+    return *pos_;
+  }
+
+  size_t remaining() const { return end_ - pos_; }
+
+  // bounds checked read position, nullptr and failbit when fewer than len bytes are left
+  const uint8_t *consume(size_t len)
+  {
+    if (!good() || remaining() < len)
+    {
+      state_ |= std::ios_base::eofbit | std::ios_base::failbit;
+      return nullptr;
+    }
+    const uint8_t *p = pos_;
+    pos_ += len;
+    return p;
+  }
+
+  template <class T>
+  void read_varint(T &v)
+  {
+    if (!good())
+      return;
+    // as with the istream decoder before, a malformed value (non-canonical, overflowing or cut
+    // off by the end of the input) is taken as read so far and only the reads after it can fail
+    tools::read_varint_from<std::numeric_limits<T>::digits>(pos_, end_, v);
+  }
+
+private:
+  const uint8_t *pos_;
+  const uint8_t *end_;
+  std::ios_base::iostate state_;
+};
 
 template <>
-struct binary_archive<false> : public binary_archive_base<std::istream, false>
+struct binary_archive<false> : public binary_archive_base<false>
 {
-  explicit binary_archive(stream_type &s) : base_type(s) {
-    auto pos = stream_.tellg();
-    stream_.seekg(0, std::ios_base::end);
-    eof_pos_ = stream_.tellg();
-    stream_.seekg(pos);
-  }
+  typedef binary_input_stream stream_type;
+
+  binary_archive(const uint8_t *data, size_t size) : stream_(data, size) { }
+  explicit binary_archive(const epee::span<const uint8_t> bytes) : stream_(bytes.data(), bytes.size()) { }
 
   template <class T>
   void serialize_int(T &v)
@@ -63,31 +117,40 @@ struct binary_archive<false> : public binary_archive_base<std::istream, false>
   template <class T>
   void serialize_uint(T &v, size_t width = sizeof(T))
   {
+    const uint8_t *p = stream_.consume(width);
+    if (!p) {
+      v = 0;
+      return;
+    }
     T ret = 0;
     unsigned shift = 0;
     for (size_t i = 0; i < width; i++) {
-      //std::cerr << "tell: " << stream_.tellg() << " value: " << ret << std::endl;
-      char c;
-      stream_.get(c);
-      T b = (unsigned char)c;
+      T b = p[i];
       ret += (b << shift);
       shift += 8;
     }
     v = ret;
   }
-  void serialize_blob(void *buf, size_t len, const char *delimiter="") { stream_.read((char *)buf, len); }
+  void serialize_blob(void *buf, size_t len, const char *delimiter="")
+  {
+    const uint8_t *p = stream_.consume(len);
+    if (p)
+      memcpy(buf, p, len);
+  }
 
   template <class T>
   void serialize_varint(T &v)
   {
-    serialize_uvarint(*(typename boost::make_unsigned<T>::type *)(&v));
+    // through a copy of the value, v may be an enum that must not be accessed as an unsigned
+    typename boost::make_unsigned<T>::type u = 0;
+    serialize_uvarint(u);
+    v = static_cast<T>(u);
   }
 
   template <class T>
   void serialize_uvarint(T &v)
   {
-    typedef std::istreambuf_iterator<char> it;
-    tools::read_varint(it(stream_), it(), v); // XXX handle failure
+    stream_.read_varint(v);
   }
   void begin_array(size_t &s)
   {
@@ -108,18 +171,44 @@ struct binary_archive<false> : public binary_archive_base<std::istream, false>
   size_t remaining_bytes() {
     if (!stream_.good())
       return 0;
-    //std::cerr << "tell: " << stream_.tellg() << std::endl;
-    assert(stream_.tellg() <= eof_pos_);
-    return eof_pos_ - stream_.tellg();
+    return stream_.remaining();
   }
+
+  stream_type &stream() { return stream_; }
 protected:
-  std::streamoff eof_pos_;
+  stream_type stream_;
+};
+
+/* Output buffer and error state of a binary_archive<true>. Bytes are appended to a caller
+ * owned string, so a buffer kept around between calls stops allocating once it has grown
+ * to the largest object written into it. */
+class binary_output_stream
+{
+public:
+  explicit binary_output_stream(std::string &buffer) : buffer_(buffer), state_(std::ios_base::goodbit) { }
+
+  bool good() const { return state_ == std::ios_base::goodbit; }
+  std::ios_base::iostate rdstate() const { return state_; }
+  void setstate(std::ios_base::iostate state) { state_ |= state; }
+  void clear(std::ios_base::iostate state = std::ios_base::goodbit) { state_ = state; }
+
+  void put(char c) { buffer_.push_back(c); }
+  void write(const void *data, size_t len) { buffer_.append(static_cast<const char *>(data), len); }
+
+  std::string &buffer() { return buffer_; }
+
+private:
+  std::string &buffer_;
+  std::ios_base::iostate state_;
 };
 
 template <>
-struct binary_archive<true> : public binary_archive_base<std::ostream, true>
+struct binary_archive<true> : public binary_archive_base<true>
 {
-  explicit binary_archive(stream_type &s) : base_type(s) { }
+  typedef binary_output_stream stream_type;
+
+  // appends to buffer, clear it first to reuse it
+  explicit binary_archive(std::string &buffer) : stream_(buffer) { }
 
   template <class T>
   void serialize_int(T v)
@@ -129,26 +218,28 @@ struct binary_archive<true> : public binary_archive_base<std::ostream, true>
   template <class T>
   void serialize_uint(T v)
   {
+    char bytes[sizeof(T)];
     for (size_t i = 0; i < sizeof(T); i++) {
-      stream_.put((char)(v & 0xff));
+      bytes[i] = (char)(v & 0xff);
       if (1 < sizeof(T)) {
         v >>= 8;
       }
     }
+    stream_.write(bytes, sizeof(T));
   }
-  void serialize_blob(void *buf, size_t len, const char *delimiter="") { stream_.write((char *)buf, len); }
+  void serialize_blob(void *buf, size_t len, const char *delimiter="") { stream_.write(buf, len); }
 
   template <class T>
   void serialize_varint(T &v)
   {
-    serialize_uvarint(*(typename boost::make_unsigned<T>::type *)(&v));
+    typename boost::make_unsigned<T>::type u = static_cast<typename boost::make_unsigned<T>::type>(v);
+    serialize_uvarint(u);
   }
 
   template <class T>
   void serialize_uvarint(T &v)
   {
-    typedef std::ostreambuf_iterator<char> it;
-    tools::write_varint(it(stream_), v);
+    tools::write_varint(std::back_inserter(stream_.buffer()), v);
   }
   void begin_array(size_t s)
   {
@@ -164,6 +255,10 @@ struct binary_archive<true> : public binary_archive_base<std::ostream, true>
   void write_variant_tag(variant_tag_type t) {
     serialize_int(t);
   }
+
+  stream_type &stream() { return stream_; }
+protected:
+  stream_type stream_;
 };
 
 POP_WARNINGS
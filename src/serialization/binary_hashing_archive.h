@@ -0,0 +1,112 @@
+// Copyright (c) 2012-2013 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/* binary_hashing_archive.h
+ *
+ * Saving archive that writes the binary_archive encoding into a Keccak sponge instead of
+ * a buffer, so an object is hashed and measured without materializing its blob */
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <boost/type_traits/make_unsigned.hpp>
+
+#include "binary_archive.h"
+#include "variant.h"
+
+extern "C" {
+#include "crypto/keccak.h"
+}
+
+/* Sponge and error state of a binary_hashing_archive<true>. The sponge can be switched
+ * between the sections of an object that are hashed separately, the byte count keeps
+ * running across all of them. */
+class keccak_output_stream
+{
+public:
+  explicit keccak_output_stream(keccak_ctx &sponge) : sponge_(&sponge), size_(0), state_(std::ios_base::goodbit) { }
+
+  bool good() const { return state_ == std::ios_base::goodbit; }
+  std::ios_base::iostate rdstate() const { return state_; }
+  void setstate(std::ios_base::iostate state) { state_ |= state; }
+  void clear(std::ios_base::iostate state = std::ios_base::goodbit) { state_ = state; }
+
+  void put(char c) { write(&c, 1); }
+  void write(const void *data, size_t len)
+  {
+    keccak_absorb(sponge_, static_cast<const uint8_t *>(data), len);
+    size_ += len;
+  }
+
+  void set_sponge(keccak_ctx &sponge) { sponge_ = &sponge; }
+  size_t size() const { return size_; }
+
+private:
+  keccak_ctx *sponge_;
+  size_t size_;
+  std::ios_base::iostate state_;
+};
+
+template <bool W>
+struct binary_hashing_archive;
+
+template <>
+struct binary_hashing_archive<true> : public binary_archive_base<true>
+{
+  typedef keccak_output_stream stream_type;
+
+  // absorbs into an initialized sponge, keccak_finalize() it once the object is written
+  explicit binary_hashing_archive(keccak_ctx &sponge) : stream_(sponge) { }
+
+  template <class T>
+  void serialize_int(T v)
+  {
+    serialize_uint(static_cast<typename boost::make_unsigned<T>::type>(v));
+  }
+  template <class T>
+  void serialize_uint(T v)
+  {
+    char bytes[sizeof(T)];
+    for (size_t i = 0; i < sizeof(T); i++) {
+      bytes[i] = (char)(v & 0xff);
+      if (1 < sizeof(T)) {
+        v >>= 8;
+      }
+    }
+    stream_.write(bytes, sizeof(T));
+  }
+  void serialize_blob(void *buf, size_t len, const char *delimiter="") { stream_.write(buf, len); }
+
+  template <class T>
+  void serialize_varint(T &v)
+  {
+    typename boost::make_unsigned<T>::type u = static_cast<typename boost::make_unsigned<T>::type>(v);
+    serialize_uvarint(u);
+  }
+
+  template <class T>
+  void serialize_uvarint(T &v)
+  {
+    uint8_t bytes[tools::varint_max_size<T>::value];
+    stream_.write(bytes, tools::write_varint_to(bytes, v));
+  }
+  void begin_array(size_t s)
+  {
+    serialize_varint(s);
+  }
+  void begin_array() { }
+  void delimit_array() { }
+  void end_array() { }
+
+  void begin_string(const char *delimiter="\"") { }
+  void end_string(const char *delimiter="\"") { }
+
+  void write_variant_tag(variant_tag_type t) {
+    serialize_int(t);
+  }
+
+  stream_type &stream() { return stream_; }
+protected:
+  stream_type stream_;
+};
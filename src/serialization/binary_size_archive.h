@@ -0,0 +1,132 @@
+// Copyright (c) 2012-2013 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/* binary_size_archive.h
+ *
+ * Saving archive that only counts the bytes binary_archive<true> would write */
+#pragma once
+
+#include <cstring>
+#include <initializer_list>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include <boost/type_traits/make_unsigned.hpp>
+
+#include "binary_archive.h"
+#include "variant.h"
+
+/* Byte count and error state of a binary_size_archive<true> */
+class binary_size_stream
+{
+public:
+  binary_size_stream() : size_(0), state_(std::ios_base::goodbit) { }
+
+  bool good() const { return state_ == std::ios_base::goodbit; }
+  std::ios_base::iostate rdstate() const { return state_; }
+  void setstate(std::ios_base::iostate state) { state_ |= state; }
+  void clear(std::ios_base::iostate state = std::ios_base::goodbit) { state_ = state; }
+
+  void put(char c) { ++size_; }
+  void write(const void *data, size_t len) { size_ += len; }
+  void skip(size_t len) { size_ += len; }
+
+  size_t size() const { return size_; }
+
+private:
+  size_t size_;
+  std::ios_base::iostate state_;
+};
+
+/* Offsets of the first field tagged with each of the given names, filled in by the
+ * binary_size_archive<true> that sizes the object */
+class binary_field_offsets
+{
+public:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  binary_field_offsets(std::initializer_list<const char *> names)
+  {
+    for (const char *name : names)
+      fields_.emplace_back(name, npos);
+  }
+
+  void record(const char *name, size_t offset)
+  {
+    for (auto &field : fields_)
+      if (field.second == npos && !strcmp(field.first, name))
+        field.second = offset;
+  }
+
+  size_t find(const char *name) const
+  {
+    for (const auto &field : fields_)
+      if (!strcmp(field.first, name))
+        return field.second;
+    return npos;
+  }
+
+private:
+  std::vector<std::pair<const char *, size_t>> fields_;
+};
+
+template <bool W>
+struct binary_size_archive;
+
+template <>
+struct binary_size_archive<true> : public binary_archive_base<true>
+{
+  typedef binary_size_stream stream_type;
+
+  explicit binary_size_archive(binary_field_offsets *offsets = nullptr) : offsets_(offsets) { }
+
+  void tag(const char *name)
+  {
+    if (offsets_)
+      offsets_->record(name, stream_.size());
+  }
+
+  template <class T>
+  void serialize_int(T v) { stream_.skip(sizeof(T)); }
+  template <class T>
+  void serialize_uint(T v) { stream_.skip(sizeof(T)); }
+  void serialize_blob(void *buf, size_t len, const char *delimiter="") { stream_.skip(len); }
+
+  template <class T>
+  void serialize_varint(T &v)
+  {
+    typename boost::make_unsigned<T>::type u = static_cast<typename boost::make_unsigned<T>::type>(v);
+    serialize_uvarint(u);
+  }
+
+  template <class T>
+  void serialize_uvarint(T &v)
+  {
+    size_t len = 1;
+    for (T i = v; i >= 0x80; i >>= 7)
+      ++len;
+    stream_.skip(len);
+  }
+  void begin_array(size_t s)
+  {
+    serialize_varint(s);
+  }
+  void begin_array() { }
+  void delimit_array() { }
+  void end_array() { }
+
+  void begin_string(const char *delimiter="\"") { }
+  void end_string(const char *delimiter="\"") { }
+
+  void write_variant_tag(variant_tag_type t) {
+    serialize_int(t);
+  }
+
+  size_t size() const { return stream_.size(); }
+
+  stream_type &stream() { return stream_; }
+protected:
+  stream_type stream_;
+  binary_field_offsets *offsets_;
+};
@@ -24,14 +24,11 @@ bool do_serialize(Archive<false> &ar, std::vector<crypto::signature> &v)
     return false;
   }
 
-  v.reserve(cnt);
-  for (size_t i = 0; i < cnt; i++) {
-    v.resize(i+1);
-    ar.serialize_blob(&(v[i]), sizeof(crypto::signature), "");
-    if (!ar.stream().good())
-      return false;
-  }
-  return true;
+  // signatures are stored back to back, they are read in one block
+  v.resize(cnt);
+  if (cnt)
+    ar.serialize_blob(v.data(), cnt*sizeof(crypto::signature), "");
+  return ar.stream().good();
 }
 
 // write
@@ -40,12 +37,9 @@ bool do_serialize(Archive<true> &ar, std::vector<crypto::signature> &v)
 {
   if (0 == v.size()) return true;
   ar.begin_string();
-  size_t cnt = v.size();
-  for (size_t i = 0; i < cnt; i++) {
-    ar.serialize_blob(&(v[i]), sizeof(crypto::signature), "");
-    if (!ar.stream().good())
-      return false;
-  }
+  ar.serialize_blob(v.data(), v.size()*sizeof(crypto::signature), "");
+  if (!ar.stream().good())
+    return false;
   ar.end_string();
   return true;
 }
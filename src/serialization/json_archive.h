@@ -13,6 +13,9 @@
 #include <iostream>
 #include <iomanip>
 
+template <bool W>
+struct json_archive;
+
 template <class Stream, bool IsSaving>
 struct json_archive_base
 {
@@ -21,6 +24,7 @@ struct json_archive_base
   typedef boost::mpl::bool_<IsSaving> is_saving;
 
   typedef const char *variant_tag_type;
+  typedef json_archive<IsSaving> variant_tag_archive;
 
   json_archive_base(stream_type &s, bool indent = false) : stream_(s), indent_(indent), object_begin(false), depth_(0) { }
 
@@ -66,9 +70,6 @@ protected:
   size_t depth_;
 };
 
-template <bool W>
-struct json_archive;
-
 template <>
 struct json_archive<true> : public json_archive_base<std::ostream, true>
 {
@@ -0,0 +1,26 @@
+// Copyright (c) 2012-2013 The Cryptonote developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include "serialization.h"
+#include "common/lazy_field.h"
+
+template <template <bool> class Archive, class T>
+inline bool do_serialize(Archive<false>& ar, tools::lazy_field<T>& f)
+{
+  return ::do_serialize(ar, f.get());
+}
+
+// an empty field is written as a default T, it stays unallocated
+template <template <bool> class Archive, class T>
+inline bool do_serialize(Archive<true>& ar, tools::lazy_field<T>& f)
+{
+  if (f.empty())
+  {
+    T value = T();
+    return ::do_serialize(ar, value);
+  }
+  return ::do_serialize(ar, f.get());
+}
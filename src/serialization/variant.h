@@ -27,14 +27,24 @@ struct variant_reader
 
   static inline bool read(Archive &ar, Variant &v, variant_tag_type t)
   {
-    if (variant_serialization_traits<Archive, current_type>::get_tag() == t) {
+    if (variant_serialization_traits<typename Archive::variant_tag_archive, current_type>::get_tag() == t) {
+      // read into the held value when the type matches, else move a new one in
+      if (current_type *held = boost::get<current_type>(&v))
+      {
+        if(!::do_serialize(ar, *held))
+        {
+          ar.stream().setstate(std::ios::failbit);
+          return false;
+        }
+        return true;
+      }
       current_type x;
       if(!::do_serialize(ar, x))
       {
         ar.stream().setstate(std::ios::failbit);
         return false;
       }
-      v = x;
+      v = std::move(x);
     } else {
       return variant_reader<Archive, Variant, TNext, TEnd>::read(ar, v, t);
     }
@@ -93,7 +103,7 @@ struct serializer<Archive<true>, boost::variant<BOOST_VARIANT_ENUM_PARAMS(T)>>
     bool operator ()(T &rv) const
     {
       ar.begin_variant();
-      ar.write_variant_tag(variant_serialization_traits<Archive<true>, T>::get_tag());
+      ar.write_variant_tag(variant_serialization_traits<typename Archive<true>::variant_tag_archive, T>::get_tag());
       if(!::do_serialize(ar, rv))
       {
         ar.stream().setstate(std::ios::failbit);
@@ -4,8 +4,12 @@
 
 #pragma once
 
+#include <boost/type_traits/is_base_of.hpp>
 #include "serialization.h"
 
+template <bool IsSaving>
+struct binary_archive_base;
+
 template <template <bool> class Archive, class T>
 bool do_serialize(Archive<false> &ar, std::vector<T> &v);
 template <template <bool> class Archive, class T>
@@ -27,6 +31,66 @@ namespace serialization
       ar.serialize_varint(e);
       return true;
     }
+
+    // Blob type elements are stored back to back in binary archives, a vector of them is moved
+    // as one block of bytes
+    template <template <bool> class Archive, bool W, class T>
+    struct is_blob_array : boost::integral_constant<bool,
+      is_blob_type<T>::type::value && boost::is_base_of<binary_archive_base<W>, Archive<W>>::value> {};
+
+    template <template <bool> class Archive, class T>
+    bool read_vector_elements(Archive<false> &ar, std::vector<T> &v, size_t cnt, boost::true_type)
+    {
+      if (ar.remaining_bytes() / sizeof(T) < cnt) {
+        ar.stream().setstate(std::ios::failbit);
+        return false;
+      }
+      v.resize(cnt);
+      if (cnt)
+        ar.serialize_blob(v.data(), cnt * sizeof(T));
+      return ar.stream().good();
+    }
+
+    template <template <bool> class Archive, class T>
+    bool read_vector_elements(Archive<false> &ar, std::vector<T> &v, size_t cnt, boost::false_type)
+    {
+      v.reserve(cnt);
+      for (size_t i = 0; i < cnt; i++) {
+        if (i > 0)
+          ar.delimit_array();
+        v.resize(i+1);
+        if (!serialize_vector_element(ar, v[i]))
+          return false;
+        if (!ar.stream().good())
+          return false;
+      }
+      return true;
+    }
+
+    template <template <bool> class Archive, class T>
+    bool write_vector_elements(Archive<true> &ar, std::vector<T> &v, boost::true_type)
+    {
+      if (!v.empty())
+        ar.serialize_blob(v.data(), v.size() * sizeof(T));
+      return ar.stream().good();
+    }
+
+    template <template <bool> class Archive, class T>
+    bool write_vector_elements(Archive<true> &ar, std::vector<T> &v, boost::false_type)
+    {
+      size_t cnt = v.size();
+      for (size_t i = 0; i < cnt; i++) {
+        if (!ar.stream().good())
+          return false;
+        if (i > 0)
+          ar.delimit_array();
+        if(!serialize_vector_element(ar, v[i]))
+          return false;
+        if (!ar.stream().good())
+          return false;
+      }
+      return true;
+    }
   }
 }
 
@@ -45,16 +109,9 @@ bool do_serialize(Archive<false> &ar, std::vector<T> &v)
     return false;
   }
 
-  v.reserve(cnt);
-  for (size_t i = 0; i < cnt; i++) {
-    if (i > 0)
-      ar.delimit_array();
-    v.resize(i+1);
-    if (!::serialization::detail::serialize_vector_element(ar, v[i]))
-      return false;
-    if (!ar.stream().good())
-      return false;
-  }
+  typedef typename ::serialization::detail::is_blob_array<Archive, false, T>::type blob_array;
+  if (!::serialization::detail::read_vector_elements(ar, v, cnt, blob_array()))
+    return false;
   ar.end_array();
   return true;
 }
@@ -64,16 +121,9 @@ bool do_serialize(Archive<true> &ar, std::vector<T> &v)
 {
   size_t cnt = v.size();
   ar.begin_array(cnt);
-  for (size_t i = 0; i < cnt; i++) {
-    if (!ar.stream().good())
-      return false;
-    if (i > 0)
-      ar.delimit_array();
-    if(!::serialization::detail::serialize_vector_element(ar, v[i]))
-      return false;
-    if (!ar.stream().good())
-      return false;
-  }
+  typedef typename ::serialization::detail::is_blob_array<Archive, true, T>::type blob_array;
+  if (!::serialization::detail::write_vector_elements(ar, v, blob_array()))
+    return false;
   ar.end_array();
   return true;
 }
@@ -0,0 +1,58 @@
+"use strict";
+let u = require('../build/Release/cryptoforknote');
+
+const b = Buffer.from(
+'1010f4b3ecb406a7e85c45ba044af4a16e0e790032f31727e3daef1a7da5ab12c9894c191713e30000000002a18ec30101ffe58dc30101c084aa98d21103d71cd8a7478f0c74e191f3dac85b4c396ec76a07311a94db04721676634ab49b1e34014f9b1e0434876de264409d8f024f5f61fdcb9297ef671518310e7add0e69bc270211000000000000000000000000000000000000238dc39cf2f9eef8084b911d6086075ea57b58793ec2a0a8683f5d890a5be1c92583892a3f5127cb3469da37719047fbdd5bc32034c996a9e3919485d36ac5f609c646379ca888796d7485d403f45ab2230b66920c8f0b1e160d4b6529f531ca95bc04dfc96e7643a9f86526ba4e899fa52d2279abf2cf8b60e4be19f9f9b293211f508353cb5496f04b7e9824395828385e7724a2e2fa42097962028fd7c5083fa3e827d9f46dbf3741181d4f4897aea254bbc2081a3455603c81bfd75961541cb3f1ad55fa277111b5e4b3b7ce10c1bbdca7e158d36deac6c09ef9827edea7d6dce44f1145831d29d7ac59e497050af0a19de855302ff70079e60761d6bae70dc45a766e7088e764e6950e5a9704e03e5a455b23a572af2950c613d6d109b2007a7c943e4b0c2513ced71179b0dd0388fa0c397b83d4ebeb616cbe89c6c2d12972bdbbe845f78189fd3b0494bcac392b8ec9a6c2d49d88c391c54fd2bf0ba45aded1dbff66fe6311c293b6ae1f47127ad936890cfc2379427be0360b68007ae3dd56083a4eb90d736370b23471dd5d2b7ee2107bd44016e20b9a948e745b2de2cbcd7780e981b0eeb646175137e8b42a9b9724263d9a84d9ba892caa209c73ca03ab832e504d309a6714e8554b13b3c05f306f0e46c06c801978e7f69727b8333709fe7c836286cefd36ef22a4681653d04a96ce91d5f97aee107f93cd5f57c3f5f553e435a910c60f426b3f3658754e72a55ea8b40eda985147558159296bfa23ab9cbbd2e8316a00b87ea81195d8b4a3d4ec2889a788af0d4ce53b4e261a1087eae0f54cc92132f87a5aadadd3ea70228df71a615b85a1d96bc031d08e6fafb41117b055c9db533d27fcacc14a251369654c377d451e2eeb7aa7d26ff12542c5b7194d2b783b493435c0bee44b9ee315aa373dd79ed7abebe2095e547867f0db8cda9a8544f306a74e96a7023e637642f63bc5fa27dcfae1a59655b7170fee88c7362f676b6b4e5aee6c94cdfda39075138bf4fb0da0f7490ea33d85d8d72a23695f30f14f65edd4715aacc897d6be2df0e6566c3d484945f2b4ac5e6dab45306d2e8704ba8590388d7d41620ed4171701c5d8eab8b0e1192075606b70dc00014089e31fee4ae2aaa3dc49c9018ec93497818eb1348bedf3b2d0af7ccc4bb5bb151a7e9b1759d46db0e3b4acb08f639ae61a43aff57f1f9f8baff9205d4350733a8bd2f99acb417ef81fd5affb56cf85019fc23bcc03359b0d57c62a94efae9028a7353f11edc5f304fd59cc24ecfcd40db5e5354ebb288d64934c4bf3e56a37c612043d49335e52a1788998cbf3a1cc09bc78c9ffbac1346a4fad340727ee9aa20c00ebf5131556fbdbf842469d31c8121feae78c3a56ba1eae5bde78c18371108601e8ae7f5698d0918be8e52afc500fa67c35b46e8011b686e9a5e20008b7dfd3eb85011f54a70832823611dc06373d1b98052a503313a6e4d0eab3ad97f04dac2305cbb4fa094c6634270289593f90ffcd460529d0835bdfe780074488d531ebb06558ba4b28ece031cfd981062beec659c6a50addfefaf2e4e1e11f95'
+, 'hex');
+// the reserved offset lies 88 bytes into the miner tx, before its first keccak block ends,
+// so the template hashes through a copy of the block instead of a miner tx midstate
+const reserved_offset = 131;
+// the same template with its extra nonce field grown by 100 bytes, which moves the reserved
+// offset 189 bytes into the miner tx and past its first keccak block
+const grown = Buffer.concat([ b.slice(0, 95), Buffer.from([ 0x98, 0x01 ]), b.slice(96, 130), Buffer.from([ 0x11 + 100 ]), Buffer.alloc(100), b.slice(131) ]);
+const grown_reserved_offset = reserved_offset + 1 + 100;
+const extra_nonce = Buffer.from('0102030405060708', 'hex');
+const nonce = Buffer.from('deadbeef', 'hex');
+
+function check(b, reserved_offset) {
+  let b2 = Buffer.from(b);
+  extra_nonce.copy(b2, reserved_offset);
+
+  const t = new u.BlockTemplate(b, 0, reserved_offset);
+  const h1 = t.hashingBlob(extra_nonce).toString('hex');
+  const h2 = t.blockBlob(nonce, extra_nonce).toString('hex');
+  const h3 = t.blockId().toString('hex');
+  const h4 = t.hashingBlob(extra_nonce).toString('hex');
+  // calls without an extra nonce get the template bytes, not the one given before
+  const h5 = t.hashingBlob().toString('hex');
+  const h6 = t.blockBlob(nonce).toString('hex');
+  const template_ok = h5 === u.convert_blob(b, 0).toString('hex') && h6 === u.construct_block_blob(b, nonce, 0).toString('hex') &&
+    t.blockId().toString('hex') === u.get_block_id(u.construct_block_blob(b, nonce, 0), 0).toString('hex');
+
+  const extra_nonces = [ extra_nonce, Buffer.from('a1a2a3a4a5a6a7a8', 'hex'), Buffer.from('ffffffff', 'hex') ];
+  const batch = u.convert_blob_batch(b, 0, reserved_offset, extra_nonces);
+  const stride = batch.length / extra_nonces.length;
+  let batch_ok = stride === h1.length / 2;
+  extra_nonces.forEach(function(en, i) {
+    let b3 = Buffer.from(b);
+    en.copy(b3, reserved_offset);
+    if (!batch.slice(i * stride, (i + 1) * stride).equals(u.convert_blob(b3, 0))) batch_ok = false;
+  });
+
+  const c2 = u.construct_block_blob(b2, nonce, 0);
+  const layout = t.layout();
+  const layout_ok = layout.size === b.length && layout.reservedOffset === reserved_offset &&
+    c2.slice(layout.nonce, layout.nonce + layout.nonceSize).equals(nonce) && layout.cycle === undefined &&
+    reserved_offset < layout.minerTxExtra + layout.minerTxExtraSize && b.length - layout.txHashes === 1 + b[layout.txHashes] * 32;
+  if (h1 === u.convert_blob(b2, 0).toString('hex') && h2 === c2.toString('hex') && h3 === u.get_block_id(c2, 0).toString('hex') && h4 === h1 && template_ok && batch_ok && layout_ok) {
+    return true;
+  }
+  console.log('FAILED: ' + reserved_offset + ' ' + h1 + ' ' + h2 + ' ' + h3);
+  return false;
+}
+
+if (check(b, reserved_offset) && check(grown, grown_reserved_offset)) {
+  console.log('PASSED');
+} else {
+  process.exit(1);
+}
@@ -0,0 +1,60 @@
+"use strict";
+let u = require('../build/Release/cryptoforknote');
+
+// a hash meets a difficulty when the hash, read as a 256 bit little endian number, times the
+// difficulty still fits 256 bits
+const max = (1n << 256n) - 1n;
+function hash_of(n) {
+  return Buffer.from(n.toString(16).padStart(64, '0'), 'hex').reverse();
+}
+function meets(hash, difficulty) {
+  return BigInt('0x' + Buffer.from(hash).reverse().toString('hex')) * BigInt(difficulty) <= max;
+}
+
+const difficulties = [ 1, 2, 1000, 120000, 4294967296, 1e15 ];
+let hashes = [], hash_difficulties = [];
+difficulties.forEach(function(difficulty) {
+  const boundary = max / BigInt(difficulty);
+  [ 0n, 1n, boundary - 1n, boundary, boundary + 1n, max ].forEach(function(n) {
+    if (n > max) return;
+    hashes.push(hash_of(n));
+    hash_difficulties.push(difficulty);
+  });
+});
+let seed = 12345;
+for (let i = 0; i < 500; ++i) {
+  let hash = Buffer.alloc(32);
+  for (let j = 0; j < 32; ++j) hash[j] = (seed = (seed * 1103515245 + 12345) % 2147483648) >> 16 & 0xff;
+  hash[31] >>= i % 32;
+  hashes.push(hash);
+  hash_difficulties.push(difficulties[i % difficulties.length]);
+}
+
+let ok = true;
+const all = Buffer.concat(hashes);
+const mask = u.check_hashes(all, hash_difficulties);
+const mask1000 = u.check_hashes(all, 1000);
+if (mask.length !== Math.ceil(hashes.length / 8)) ok = false;
+hashes.forEach(function(hash, i) {
+  const expected = meets(hash, hash_difficulties[i]);
+  if (u.check_hash(hash, hash_difficulties[i]) !== expected) ok = false;
+  if (!!(mask[i >> 3] & 1 << (i & 7)) !== expected) ok = false;
+  if (!!(mask1000[i >> 3] & 1 << (i & 7)) !== meets(hash, 1000)) ok = false;
+});
+
+let bad_args = 0;
+[ function() { u.check_hashes(Buffer.alloc(31), 1); },
+  function() { u.check_hashes(all, [ 1 ]); },
+  function() { u.check_hash(Buffer.alloc(32), -1); } ].forEach(function(f) {
+  try { f(); } catch (e) { ++bad_args; }
+});
+if (bad_args !== 3) ok = false;
+
+u.check_hashes_async(all, hash_difficulties).then(function(r) {
+  if (ok && r.equals(mask)) {
+    console.log('PASSED');
+  } else {
+    console.log('FAILED: ' + mask.toString('hex'));
+    process.exit(1);
+  }
+});
@@ -0,0 +1,105 @@
+"use strict";
+let u = require('../build/Release/cryptoforknote');
+
+// reference versions of both algorithms over the blocks they look at
+function cryptonote(timestamps, cumulative, target, window, lag, cut) {
+  timestamps = timestamps.slice(-(window + lag)).slice(0, window).sort(function(a, b) { return a - b; });
+  cumulative = cumulative.slice(-(window + lag)).slice(0, window);
+  const length = timestamps.length;
+  if (length <= 1) return 1n;
+  let begin = 0, end = length;
+  if (length > window - 2 * cut) {
+    begin = Math.floor((length - (window - 2 * cut) + 1) / 2);
+    end = begin + window - 2 * cut;
+  }
+  const span = BigInt(Math.max(timestamps[end - 1] - timestamps[begin], 1));
+  return (BigInt.asUintN(64, BigInt(cumulative[end - 1]) - BigInt(cumulative[begin])) * BigInt(target) + span - 1n) / span;
+}
+// zawy's LWMA-1 reference code, in its wrapping 64 bit arithmetic
+function lwma(timestamps, cumulative, target, window) {
+  if (timestamps.length < window + 1) return 1n;
+  timestamps = timestamps.slice(-(window + 1));
+  cumulative = cumulative.slice(-(window + 1));
+  const u64 = function(x) { return BigInt.asUintN(64, x); };
+  const T = BigInt(target), N = BigInt(window);
+  let L = 0n, previous = timestamps[0] - target;
+  for (let i = 1; i <= window; ++i) {
+    const adjusted = timestamps[i] > previous ? timestamps[i] : previous + 1;
+    L += BigInt(i * Math.min(6 * target, adjusted - previous));
+    previous = adjusted;
+  }
+  if (L < N * N * T / 20n) L = N * N * T / 20n;
+  const average = u64(BigInt(cumulative[window]) - BigInt(cumulative[0])) / N;
+  let next = average > 2000000n * N * N * T ? u64(average / (200n * L) * (N * (N + 1n) * T * 99n))
+                                            : u64(average * N * (N + 1n) * T * 99n) / (200n * L);
+  for (let unit = 1000000000n; unit > 1n; unit /= 10n) {
+    if (next > unit * 100n) { next = u64((next + unit / 2n) / unit * unit); break; }
+  }
+  return next;
+}
+
+let ok = true;
+let timestamps = [], cumulative = [], t = 1600000000, c = 0;
+for (let i = 0; i < 800; ++i) {
+  timestamps.push(t += 120);
+  cumulative.push(c += 1000000);
+}
+if (u.next_difficulty(timestamps, cumulative) !== 1000000n) ok = false;
+// LWMA-1 puts the block before its window one target back, so the first solve time is doubled,
+// and rounds 989459 to three significant digits
+if (u.next_difficulty(timestamps, cumulative, 1) !== 989000n) ok = false;
+// not before a full window
+if (u.next_difficulty(timestamps.slice(0, 60), cumulative.slice(0, 60), 1) !== 1n) ok = false;
+
+// pinned results of the reference code over 60 blocks of 120 seconds: average difficulties
+// rounded, wrapped past 64 bits, and divided first
+const solve_times = [ 95, 301, 12, 140, -40, 88, 610, 3, 77, 122, 230, 41, 160, 118, 9, 1020, 54, 133, 70, 202,
+                      -15, 66, 180, 125, 97, 14, 350, 111, 48, 140, 260, 5, 130, 99, 81, 172, 36, 120, 455, 63,
+                      118, 27, 144, 201, 90, 11, 128, 310, 74, 150, 22, 119, 103, 860, 40, 131, 66, 170, 84, 121 ];
+[ [ 250000000n, 210000000n ], [ 480000000000n, 47800000000n ], [ 3000000000000000n, 2517070000000000n ] ].forEach(function(pinned) {
+  const base = pinned[0], chain = new u.DifficultyWindow(1);
+  let time = 1700000000, work = base * 1000n;
+  const times = [ time ], works = [ work ];
+  chain.addBlock(time, work);
+  solve_times.forEach(function(solve_time, i) {
+    times.push(time += solve_time);
+    works.push(work += base + base / 1000n * BigInt(i % 7));
+    chain.addBlock(time, work);
+  });
+  if (u.next_difficulty(times, works, 1) !== pinned[1] || chain.nextDifficulty() !== pinned[1] || lwma(times, works, 120, 60) !== pinned[1]) ok = false;
+});
+
+// out of order timestamps and cumulative difficulties past 2^64 as BigInt
+let seed = 4321;
+function random(n) { return (seed = (seed * 1103515245 + 12345) % 2147483648) % n; }
+timestamps = []; cumulative = []; c = 2n ** 64n - 5000000000n;
+const settings = [ [ 0, 120, 720, 15, 60 ], [ 0, 60, 30, 3, 6 ], [ 1, 120, 60 ], [ 1, 240, 45 ] ];
+const windows = settings.map(function(s) { return new u.DifficultyWindow(...s); });
+for (let i = 0; i < 1000; ++i) {
+  timestamps.push(t += random(5) ? random(360) : -random(480));
+  cumulative.push(c += BigInt(1 + random(100000000)));
+  const plain = cumulative.map(function(d) { return d % 2n ** 64n; });
+  settings.forEach(function(s, j) {
+    windows[j].addBlock(timestamps[i], cumulative[i]);
+    const expected = s[0] ? lwma(timestamps, plain, s[1], s[2]) : cryptonote(timestamps, plain, s[1], s[2], s[3], s[4]);
+    if (windows[j].nextDifficulty() !== expected || u.next_difficulty(timestamps, cumulative, ...s) !== expected) ok = false;
+  });
+}
+
+let bad_args = 0;
+[ function() { u.next_difficulty([ 1, 2 ], [ 1 ]); },
+  function() { u.next_difficulty([ 1 ], [ 1 ], 2); },
+  function() { new u.DifficultyWindow(0, 120, 100, 0, 50); },
+  function() { windows[0].addBlock(-1, 1); } ].forEach(function(f) {
+  try { f(); } catch (e) { ++bad_args; }
+});
+if (bad_args !== 4) ok = false;
+// difficulties past 2^53 come back as BigInt and are taken back by check_hash
+if (u.check_hash(Buffer.alloc(32), 2n ** 64n - 1n) !== true) ok = false;
+
+if (ok) {
+  console.log('PASSED');
+} else {
+  console.log('FAILED');
+  process.exit(1);
+}
@@ -3,11 +3,17 @@
 DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
 
 cd $DIR
+node async.js || exit 1
 node bloc.js || exit 1
+node block_template.js || exit 1
+node check_hash.js || exit 1
+node difficulty.js || exit 1
 node ird.js  || exit 1
 node msr.js  || exit 1
 node ryo.js  || exit 1
 node sal.js  || exit 1
+node thread_pool.js || exit 1
+g++ -std=c++17 -O2 -I../src thread_pool_nested.cpp ../src/common/thread_pool.cpp -lpthread -o "${TMPDIR:-/tmp}/thread_pool_nested" && "${TMPDIR:-/tmp}/thread_pool_nested" || exit 1
 node tube.js || exit 1
 node xeq.js  || exit 1
 node xhv.js  || exit 1
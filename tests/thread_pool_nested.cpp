@@ -0,0 +1,52 @@
+// Nested parallel_for while the pool is resized from another thread, built and run by run.sh:
+// g++ -std=c++17 -O2 -I../src thread_pool_nested.cpp ../src/common/thread_pool.cpp -lpthread
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include <thread>
+
+#include "common/thread_pool.h"
+
+int main()
+{
+  tools::threadpool& pool = tools::threadpool::instance();
+  std::atomic<bool> done(false);
+  std::atomic<size_t> bad(0);
+
+  std::thread resizer([&]() {
+    for (unsigned i = 0; !done; ++i)
+      pool.set_threads(2 + i % 3, false);
+  });
+
+  std::future<void> batches = std::async(std::launch::async, [&]() {
+    for (int round = 0; round < 2000; ++round)
+    {
+      std::atomic<size_t> sum(0);
+      pool.parallel_for(16, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i != end; ++i)
+          pool.parallel_for(16, [&](size_t b, size_t e) { sum += e - b; });
+      });
+      if (sum != 16 * 16)
+        ++bad;
+    }
+  });
+
+  const bool finished = batches.wait_for(std::chrono::seconds(120)) == std::future_status::ready;
+  if (!finished)
+  {
+    std::printf("FAILED: nested parallel_for deadlocked against set_threads\n");
+    std::_Exit(1);
+  }
+  done = true;
+  resizer.join();
+  if (bad)
+  {
+    std::printf("FAILED: %zu batches lost chunks\n", size_t(bad));
+    return 1;
+  }
+  std::printf("PASSED\n");
+  return 0;
+}
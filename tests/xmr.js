@@ -6,8 +6,11 @@ const b = Buffer.from(
 , 'hex');
 const b2 = u.convert_blob(b, 0);
 const h1 = b2.toString('hex');
+// the timestamp varint with a trailing zero group, which parses as leniently as before
+const b3 = Buffer.concat([ b.slice(0, 6), Buffer.from('8600', 'hex'), b.slice(7) ]);
+const h3 = u.convert_blob(b3, 0).toString('hex');
 
-if (h1 === '1010f4b3ecb406a7e85c45ba044af4a16e0e790032f31727e3daef1a7da5ab12c9894c191713e300000000980c1b19961064ad5ceba387074e29030eac8378bcb38f5a50189f8892c4578324') {
+if (h3 === h1 && h1 === '1010f4b3ecb406a7e85c45ba044af4a16e0e790032f31727e3daef1a7da5ab12c9894c191713e300000000980c1b19961064ad5ceba387074e29030eac8378bcb38f5a50189f8892c4578324') {
   console.log('PASSED');
 } else {
   console.log('FAILED: ' + h1);